@@ -3,8 +3,13 @@
 
 #include <obs-module.h>
 
+#include <atomic>
+
 #include "models/Model.h"
 #include "ort-utils/ORTModelData.h"
+#include "ort-utils/ort-session-builder.h"
+#include "obs-utils/filter-stats.h"
+#include "cv-utils/yuv-kernels.h"
 
 /**
   * @brief The filter_data struct
@@ -13,27 +18,65 @@
   *
 */
 struct filter_data : public ORTModelData {
-	std::string useGPU;
-	uint32_t numThreads;
-	std::string modelSelection;
-	std::unique_ptr<Model> model;
-
 	obs_source_t *source;
 	gs_texrender_t *texrender;
 	gs_stagesurf_t *stagesurface;
 
 	cv::Mat inputBGRA;
+	// Input frame of an async target in its YUV layout, instead of inputBGRA when
+	// acceptsYuvInput. Only one of the two holds a frame.
+	YuvImage inputYUV;
+	// The tick preprocesses YUV frames itself
+	bool acceptsYuvInput = false;
+	// Render frame time (obs_get_video_frame_time) inputBGRA was read back in
+	uint64_t inputFrameTime;
+	// Frame time of the frame the current tick processes (tick thread only)
+	uint64_t frameTime;
+	// When the last frame of an async target was taken in filter_video, 0 if never
+	std::atomic<uint64_t> asyncFrameTime{0};
+	// Planes of the async frame, gathered for the color conversion
+	cv::Mat asyncFrameScratch;
 
 	bool isDisabled;
 
+	// Performance counters, guarded by outputLock
+	FilterStats stats;
+
 	std::mutex inputBGRALock;
 	std::mutex outputLock;
+	// Guards the session and model (the ORTModelData part) against a background swap
+	std::mutex modelMutex;
+
+	std::unique_ptr<OrtSessionBuilder> sessionBuilder;
+	// Model, device and threads of the most recently requested session.
+	// Requests come from update (settings) and video_tick (provider fallback).
+	std::string requestedSessionKey;
+	std::mutex requestedSessionKeyLock;
+	// Execution provider a runtime failure fell back to, kept across settings
+	// changes until the useGPU setting itself changes. Guarded by
+	// requestedSessionKeyLock.
+	std::string fallbackProvider;
+	std::string useGPUSetting;
+
+	/**
+	  * @brief The execution provider to request for the useGPU setting: the one a
+	  * runtime failure fell back to, unless the setting changed since
+	*/
+	std::string resolveExecutionProvider(const std::string &useGPU)
+	{
+		std::lock_guard<std::mutex> lock(requestedSessionKeyLock);
+		if (useGPU != useGPUSetting) {
+			useGPUSetting = useGPU;
+			fallbackProvider.clear();
+		}
+		return fallbackProvider.empty() ? useGPU : fallbackProvider;
+	}
 
-#if _WIN32
-	std::wstring modelFilepath;
-#else
-	std::string modelFilepath;
-#endif
+	void setFallbackProvider(const std::string &provider)
+	{
+		std::lock_guard<std::mutex> lock(requestedSessionKeyLock);
+		fallbackProvider = provider;
+	}
 };
 
 #endif /* FILTERDATA_H */
@@ -8,29 +8,73 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <atomic>
 #include <numeric>
+#include <map>
 #include <memory>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <future>
 #include <new>
 #include <mutex>
 #include <regex>
+#include <set>
+#include <sstream>
 #include <thread>
 
 #include <plugin-support.h>
-#include "models/ModelSINET.h"
-#include "models/ModelMediapipe.h"
-#include "models/ModelSelfie.h"
+#include "models/ModelRegistry.h"
 #include "models/ModelRVM.h"
-#include "models/ModelPPHumanSeg.h"
-#include "models/ModelTCMonoDepth.h"
-#include "models/ModelRMBG.h"
 #include "FilterData.h"
 #include "ort-utils/ort-session-utils.h"
+#include "ort-utils/ort-auto-tune.h"
 #include "obs-utils/obs-utils.h"
+#include "obs-utils/shared-results.h"
+#include "cv-utils/mat-allocation-counter.h"
+#include "cv-utils/change-map.h"
+#include "cpu-utils/thread-placement.h"
 #include "consts.h"
 #include "update-checker/update-checker.h"
 
+// How the mask is brought to the source resolution
+enum MaskUpscale {
+	// Resized, thresholded and feathered on the CPU at the source resolution
+	MASK_UPSCALE_CPU = 0,
+	// Uploaded at network resolution and sampled bicubically in the shader
+	MASK_UPSCALE_BICUBIC = 1,
+	// Uploaded at network resolution, the shader thresholds the smoothed mask as a
+	// signed distance field with an antialiased edge
+	MASK_UPSCALE_SDF = 2,
+};
+
+// Longest output delay of the sync mode, in frames
+static const uint32_t SYNC_MAX_DELAY_FRAMES = 8;
+// Masks over which the pipeline latency is measured before the delay may shrink
+static const int SYNC_LATENCY_WINDOW = 60;
+// How often the stats overlay text is redrawn
+static const std::chrono::milliseconds STATS_OVERLAY_REFRESH(250);
+// Share of the frame interval the auto-tuner lets the inference take, the rest is
+// left to the mask post-processing, rendering and encoding
+static const double AUTOTUNE_FRAME_BUDGET_SHARE = 0.5;
+
+/**
+  * @brief A frame the sync mode held back, on the GPU
+*/
+struct SyncFrame {
+	gs_texture_t *texture = nullptr;
+	uint64_t frameTime = 0;
+};
+
+/**
+  * @brief A mask kept for the sync mode, with the frame it was computed from
+*/
+struct SyncMask {
+	uint64_t frameTime = 0;
+	cv::Mat mask;
+	int upscale = 0;
+};
+
 struct background_removal_filter : public filter_data {
 	bool enableThreshold = true;
 	float threshold = 0.5f;
@@ -38,13 +82,57 @@ struct background_removal_filter : public filter_data {
 	float contourFilter = 0.05f;
 	float smoothContour = 0.5f;
 	float feather = 0.0f;
+	int maskUpscale = MASK_UPSCALE_CPU;
 
 	cv::Mat backgroundMask;
+	// How the shader samples backgroundMask (a MaskUpscale), 0 for a full
+	// resolution mask. Both are guarded by outputLock.
+	int backgroundMaskUpscale = MASK_UPSCALE_CPU;
+	// Frame time of the frame backgroundMask was computed from
+	uint64_t backgroundMaskFrameTime = 0;
+	// Parent source whose "get_mask" this filter answers, written under maskProcMutex
+	const obs_source_t *maskProcParent = nullptr;
+
+	// Sync mode: the video is delayed so each frame is composited with its own mask
+	bool syncOutput = false;
+	// Held back frames, newest first (render thread only)
+	std::deque<SyncFrame> syncFrames;
+	// Video frame time the newest frame was held back at (render thread only)
+	uint64_t syncRenderTime = 0;
+	// Recent masks, a ring guarded by outputLock
+	std::vector<SyncMask> syncMasks;
+	size_t syncMaskNext = 0;
+	// Output delay in frames, from the measured mask latency
+	uint32_t syncDelayFrames = 1;
+	uint64_t syncLastMaskFrameTime = 0;
+	uint64_t syncWindowMaxLatency = 0;
+	int syncWindowCount = 0;
 	cv::Mat lastBackgroundMask;
-	cv::Mat lastImageBGRA;
+	// The previous frame, or its luma for YUV input, for the similarity check
+	cv::Mat lastSimilarityImage;
+
+	// Per-tick buffers, reused across frames so steady-state ticks don't allocate
+	cv::Mat frameBGRA;
+	YuvImage frameYUV;
+	cv::Mat lumaScratch;
+	cv::Mat modelOutput;
+	cv::Mat networkMask;
+	cv::Mat fullMask;
+	cv::Mat maskScratch;
+	cv::Mat componentLabels;
+	cv::Mat componentStats;
+	cv::Mat componentCentroids;
+	std::vector<uint8_t> componentValues;
 	float temporalSmoothFactor = 0.0f;
 	float imageSimilarityThreshold = 35.0f;
 	bool enableImageSimilarity = true;
+
+	// Inference skipped while the frame doesn't move near the mask edge (tick thread
+	// only, besides the setting)
+	bool enableChangeMap = false;
+	ChangeMap changeMap;
+	// The mask of the last inference, before smoothing
+	cv::Mat lastModelMask;
 	int maskEveryXFrames = 1;
 	int maskEveryXFramesCount = 0;
 	int64_t blurBackground = 0;
@@ -52,10 +140,41 @@ struct background_removal_filter : public filter_data {
 	float blurFocusPoint = 0.1f;
 	float blurFocusDepth = 0.1f;
 
+	// Focal blur from a depth model, run concurrently with the segmentation model,
+	// so the person mask still cuts out the foreground
+	bool enableDepthBlur = false;
+	int depthEveryXFrames = 4;
+	int depthEveryXFramesCount = 0;
+	// The depth session, guarded by depthMutex
+	ORTModelData depth;
+	std::mutex depthMutex;
+	std::unique_ptr<OrtSessionBuilder> depthSessionBuilder;
+	std::string requestedDepthSessionKey;
+	// Depth inference output (depth thread only)
+	cv::Mat depthOutput;
+	// The latest depth map, 255 at the back, guarded by outputLock
+	cv::Mat depthMap;
+	// RVM downsample_ratio, 0 = off (network resolution), < 0 = auto
+	float rvmDownsampleRatio = 0.0f;
+	// Source size the last session rebuild was requested for (tick thread only)
+	cv::Size followedSourceSize;
+	// The model setting the performance settings were last tuned for (UI thread)
+	std::string settingsModel;
+
+	// The auto-tuner benchmarks configurations on a frame of the source in the
+	// background. The tick skips inference meanwhile, not to skew the timings.
+	std::thread autoTuneThread;
+	std::atomic<bool> autoTuning{false};
+	std::atomic<bool> autoTuneCancelled{false};
+
+	// Debug overlay of the mask and the stats, its text texture is redrawn a few
+	// times a second (render thread only)
+	bool statsOverlay = false;
+	gs_texture_t *statsTexture = nullptr;
+	std::chrono::steady_clock::time_point statsTextureTime;
+
 	gs_effect_t *effect;
 	gs_effect_t *kawaseBlurEffect;
-
-	std::mutex modelMutex;
 };
 
 void background_removal_thread(void *data); // Forward declaration
@@ -110,6 +229,8 @@ static bool enable_advanced_settings(obs_properties_t *ppts, obs_property_t *p,
 
 	for (const char *prop_name :
 	     {"model_select", "useGPU", "mask_every_x_frames", "numThreads",
+	      "inference_resolution", "rvm_downsample_ratio", "warmup_runs",
+	      "mask_upscale", "sync_output", "stats_overlay", "change_map",
 	      "enable_focal_blur", "enable_threshold", "threshold_group",
 	      "focal_blur_group", "temporal_smooth_factor",
 	      "image_similarity_threshold", "enable_image_similarity"}) {
@@ -126,6 +247,177 @@ static bool enable_advanced_settings(obs_properties_t *ppts, obs_property_t *p,
 	return true;
 }
 
+/**
+  * @brief Create an unbuilt session of a segmentation model, for the session builder
+  * or the auto-tuner
+*/
+static std::unique_ptr<ORTModelData>
+stageSession(const ModelDescriptor &descriptor, const std::string &useGPU,
+	     uint32_t numThreads, uint32_t inferenceShortSide,
+	     float rvmDownsampleRatio, const std::shared_ptr<Ort::Env> &env)
+{
+	std::unique_ptr<ORTModelData> staged(new ORTModelData);
+	staged->modelSelection = descriptor.file;
+	staged->useGPU = useGPU;
+	staged->numThreads = numThreads;
+	staged->inferenceShortSide = inferenceShortSide;
+	staged->env = env;
+
+	staged->model = createModel(descriptor);
+	if (!staged->model) {
+		return nullptr;
+	}
+	ModelRVM *modelRVM = dynamic_cast<ModelRVM *>(staged->model.get());
+	if (modelRVM) {
+		modelRVM->downsampleRatio = rvmDownsampleRatio;
+	}
+	return staged;
+}
+
+/**
+  * @brief The execution providers the auto-tuner tries, those of the device list that
+  * the ONNX Runtime build includes
+*/
+static std::vector<std::string> getAutoTuneProviders()
+{
+	std::vector<std::string> providers;
+	// TensorRT is left out, its engine build takes minutes per candidate
+	for (const char *provider : {USEGPU_CPU, USEGPU_XNNPACK, USEGPU_DNNL,
+#if defined(__linux__) && defined(__x86_64__)
+				     USEGPU_CUDA,
+#endif
+#if _WIN32
+				     USEGPU_DML,
+#endif
+#if defined(__APPLE__)
+				     USEGPU_COREML,
+#endif
+	     }) {
+		if (isExecutionProviderAvailable(provider)) {
+			providers.push_back(provider);
+		}
+	}
+	return providers;
+}
+
+/**
+  * @brief A tuned configuration to apply to a filter's settings on the UI thread
+*/
+struct AutoTuneResult {
+	obs_weak_source_t *source;
+	TuneConfig config;
+};
+
+static void applyAutoTuneResult(void *param)
+{
+	AutoTuneResult *result = reinterpret_cast<AutoTuneResult *>(param);
+	// The filter may have been removed while tuning
+	obs_source_t *source = obs_weak_source_get_source(result->source);
+	if (source) {
+		obs_data_t *settings = obs_data_create();
+		obs_data_set_string(settings, "useGPU",
+				    result->config.useGPU.c_str());
+		obs_data_set_int(settings, "numThreads",
+				 result->config.numThreads);
+		obs_data_set_int(settings, "inference_resolution",
+				 result->config.inferenceShortSide);
+		obs_data_set_int(settings, "mask_every_x_frames",
+				 result->config.maskEveryXFrames);
+		obs_source_update(source, settings);
+		obs_data_release(settings);
+		obs_source_release(source);
+	}
+	obs_weak_source_release(result->source);
+	delete result;
+}
+
+static void autoTuneThread(struct background_removal_filter *tf,
+			   cv::Mat frameBGRA, std::string modelSelection,
+			   float rvmDownsampleRatio)
+{
+	applyThreadPlacement();
+
+	const ModelDescriptor *descriptor = findModelDescriptor(modelSelection);
+	const std::shared_ptr<Ort::Env> env = tf->env;
+	const double frameBudgetMs = (double)obs_get_frame_interval_ns() / 1e6 *
+				     AUTOTUNE_FRAME_BUDGET_SHARE;
+	obs_log(LOG_INFO, "Auto-tuning %s on a %dx%d frame",
+		modelSelection.c_str(), frameBGRA.cols, frameBGRA.rows);
+
+	TuneConfig best;
+	const bool tuned =
+		descriptor != nullptr &&
+		autoTuneSession(
+			frameBGRA,
+			[&](const std::string &useGPU, uint32_t numThreads,
+			    uint32_t inferenceShortSide) {
+				return stageSession(*descriptor, useGPU,
+						    numThreads,
+						    inferenceShortSide,
+						    rvmDownsampleRatio, env);
+			},
+			getAutoTuneProviders(), frameBudgetMs,
+			[tf] { return tf->autoTuneCancelled.load(); }, best);
+
+	if (tuned && !tf->autoTuneCancelled) {
+		saveTunedConfig(modelSelection, best);
+		obs_queue_task(OBS_TASK_UI, applyAutoTuneResult,
+			       new AutoTuneResult{
+				       obs_source_get_weak_source(tf->source),
+				       best},
+			       false);
+	} else if (!tf->autoTuneCancelled) {
+		obs_log(LOG_WARNING, "Auto-tuning %s failed",
+			modelSelection.c_str());
+	}
+	tf->autoTuning = false;
+}
+
+static bool autoTuneClicked(obs_properties_t *props, obs_property_t *p,
+			    void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(p);
+	struct background_removal_filter *tf =
+		reinterpret_cast<background_removal_filter *>(data);
+	if (tf->autoTuning) {
+		return false;
+	}
+
+	// Tune on a real frame of the source, at its resolution
+	cv::Mat frameBGRA;
+	{
+		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
+		if (!tf->inputYUV.empty()) {
+			cv::Mat scratch;
+			yuvToBGRA(tf->inputYUV, scratch, frameBGRA);
+		} else {
+			tf->inputBGRA.copyTo(frameBGRA);
+		}
+	}
+	if (frameBGRA.empty()) {
+		obs_log(LOG_WARNING,
+			"Auto-tune needs a frame of the source, is it showing?");
+		return false;
+	}
+
+	if (tf->autoTuneThread.joinable()) {
+		tf->autoTuneThread.join();
+	}
+	obs_data_t *settings = obs_source_get_settings(tf->source);
+	const std::string modelSelection =
+		obs_data_get_string(settings, "model_select");
+	obs_data_release(settings);
+
+	tf->autoTuneCancelled = false;
+	tf->autoTuning = true;
+	tf->autoTuneThread = std::thread(autoTuneThread, tf, frameBGRA,
+					 modelSelection,
+					 tf->rvmDownsampleRatio);
+	// Show that the tuner runs
+	return true;
+}
+
 obs_properties_t *background_filter_properties(void *data)
 {
 	obs_properties_t *props = obs_properties_create();
@@ -166,6 +458,20 @@ obs_properties_t *background_filter_properties(void *data)
 				 obs_module_text("ThresholdGroup"),
 				 OBS_GROUP_NORMAL, threshold_props);
 
+	/* Mask upscaling, on the CPU or in the shader */
+	obs_property_t *p_mask_upscale = obs_properties_add_list(
+		props, "mask_upscale", obs_module_text("MaskUpscale"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p_mask_upscale,
+				  obs_module_text("MaskUpscaleCPU"),
+				  MASK_UPSCALE_CPU);
+	obs_property_list_add_int(p_mask_upscale,
+				  obs_module_text("MaskUpscaleBicubic"),
+				  MASK_UPSCALE_BICUBIC);
+	obs_property_list_add_int(p_mask_upscale,
+				  obs_module_text("MaskUpscaleSDF"),
+				  MASK_UPSCALE_SDF);
+
 	/* GPU, CPU and performance Props */
 	obs_property_t *p_use_gpu = obs_properties_add_list(
 		props, "useGPU", obs_module_text("InferenceDevice"),
@@ -173,6 +479,17 @@ obs_properties_t *background_filter_properties(void *data)
 
 	obs_property_list_add_string(p_use_gpu, obs_module_text("CPU"),
 				     USEGPU_CPU);
+	// Alternative CPU providers, only if the ONNX Runtime build includes them
+	if (isExecutionProviderAvailable(USEGPU_XNNPACK)) {
+		obs_property_list_add_string(p_use_gpu,
+					     obs_module_text("CPUXNNPACK"),
+					     USEGPU_XNNPACK);
+	}
+	if (isExecutionProviderAvailable(USEGPU_DNNL)) {
+		obs_property_list_add_string(p_use_gpu,
+					     obs_module_text("CPUOneDNN"),
+					     USEGPU_DNNL);
+	}
 #if defined(__linux__) && defined(__x86_64__)
 	obs_property_list_add_string(p_use_gpu, obs_module_text("GPUTensorRT"),
 				     USEGPU_TENSORRT);
@@ -193,30 +510,55 @@ obs_properties_t *background_filter_properties(void *data)
 			       300, 1);
 	obs_properties_add_int_slider(props, "numThreads",
 				      obs_module_text("NumThreads"), 0, 8, 1);
+	obs_properties_add_int_slider(props, "warmup_runs",
+				      obs_module_text("WarmupRuns"), 0, 10, 1);
+	obs_properties_add_button(props, "auto_tune",
+				  obs_module_text("AutoTune"), autoTuneClicked);
 
 	/* Model selection Props */
 	obs_property_t *p_model_select = obs_properties_add_list(
 		props, "model_select", obs_module_text("SegmentationModel"),
 		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
 
-	obs_property_list_add_string(p_model_select, obs_module_text("SINet"),
-				     MODEL_SINET);
-	obs_property_list_add_string(
-		p_model_select, obs_module_text("MediaPipe"), MODEL_MEDIAPIPE);
-	obs_property_list_add_string(p_model_select,
-				     obs_module_text("Selfie Segmentation"),
-				     MODEL_SELFIE);
-	obs_property_list_add_string(p_model_select,
-				     obs_module_text("PPHumanSeg"),
-				     MODEL_PPHUMANSEG);
-	obs_property_list_add_string(p_model_select,
-				     obs_module_text("Robust Video Matting"),
-				     MODEL_RVM);
-	obs_property_list_add_string(p_model_select,
-				     obs_module_text("TCMonoDepth"),
-				     MODEL_DEPTH_TCMONODEPTH);
-	obs_property_list_add_string(p_model_select, obs_module_text("RMBG"),
-				     MODEL_RMBG);
+	addModelsToList(p_model_select, MODEL_FILTER_BACKGROUND);
+
+	/* Inference resolution, for models with dynamic input dims */
+	obs_property_t *p_inference_resolution = obs_properties_add_list(
+		props, "inference_resolution",
+		obs_module_text("InferenceResolution"), OBS_COMBO_TYPE_LIST,
+		OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(p_inference_resolution,
+				  obs_module_text("ModelDefault"), 0);
+	for (int shortSide : {144, 192, 256, 384, 512}) {
+		const std::string label = std::to_string(shortSide) + "p";
+		obs_property_list_add_int(p_inference_resolution,
+					  label.c_str(), shortSide);
+	}
+
+	/* RVM runs at the source resolution, downsampled internally */
+	obs_property_t *p_rvm_downsample_ratio = obs_properties_add_list(
+		props, "rvm_downsample_ratio",
+		obs_module_text("RVMDownsampleRatio"), OBS_COMBO_TYPE_LIST,
+		OBS_COMBO_FORMAT_FLOAT);
+	obs_property_list_add_float(p_rvm_downsample_ratio,
+				    obs_module_text("RVMDownsampleOff"), 0.0);
+	obs_property_list_add_float(p_rvm_downsample_ratio,
+				    obs_module_text("RVMDownsampleAuto"), -1.0);
+	for (double ratio : {0.5, 0.4, 0.25, 0.125}) {
+		char label[16];
+		snprintf(label, sizeof(label), "%g", ratio);
+		obs_property_list_add_float(p_rvm_downsample_ratio, label,
+					    ratio);
+	}
+
+	obs_properties_add_bool(props, "sync_output",
+				obs_module_text("SyncOutput"));
+
+	obs_properties_add_bool(props, "stats_overlay",
+				obs_module_text("StatsOverlay"));
+
+	obs_properties_add_bool(props, "change_map",
+				obs_module_text("ChangeMap"));
 
 	obs_properties_add_float_slider(props, "temporal_smooth_factor",
 					obs_module_text("TemporalSmoothFactor"),
@@ -251,6 +593,10 @@ obs_properties_t *background_filter_properties(void *data)
 	obs_properties_add_float_slider(focal_blur_props, "blur_focus_depth",
 					obs_module_text("BlurFocusDepth"), 0.0,
 					0.3, 0.02);
+	obs_properties_add_bool(focal_blur_props, "enable_depth_blur",
+				obs_module_text("EnableDepthBlur"));
+	obs_properties_add_int(focal_blur_props, "depth_every_x_frames",
+			       obs_module_text("DepthEveryXFrames"), 1, 30, 1);
 
 	obs_properties_add_group(props, "focal_blur_group",
 				 obs_module_text("FocalBlurGroup"),
@@ -270,7 +616,32 @@ obs_properties_t *background_filter_properties(void *data)
 	obs_properties_add_text(props, "info", basic_info.c_str(),
 				OBS_TEXT_INFO);
 
-	UNUSED_PARAMETER(data);
+	if (data != nullptr) {
+		struct background_removal_filter *tf =
+			reinterpret_cast<background_removal_filter *>(data);
+		addTimeToFirstOutputInfo(props, tf);
+		addFilterStatsInfo(props, tf);
+		if (tf->autoTuning) {
+			obs_properties_add_text(props, "auto_tune_running",
+						obs_module_text("AutoTuneRunning"),
+						OBS_TEXT_INFO);
+		}
+		if (tf->syncOutput) {
+			// The delay to match with the source's audio sync offset
+			char value[64];
+			snprintf(value, sizeof(value), " %u frames (%.0f ms)",
+				 tf->syncDelayFrames,
+				 (double)(tf->syncDelayFrames *
+					  obs_get_frame_interval_ns()) /
+					 1e6);
+			const std::string info =
+				std::string(obs_module_text("SyncOutputDelay")) +
+				value;
+			obs_properties_add_text(props, "sync_output_delay",
+						info.c_str(), OBS_TEXT_INFO);
+		}
+	}
+
 	return props;
 }
 
@@ -282,6 +653,7 @@ void background_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_double(settings, "contour_filter", 0.05);
 	obs_data_set_default_double(settings, "smooth_contour", 0.5);
 	obs_data_set_default_double(settings, "feather", 0.0);
+	obs_data_set_default_int(settings, "mask_upscale", MASK_UPSCALE_CPU);
 #if _WIN32
 	obs_data_set_default_string(settings, "useGPU", USEGPU_DML);
 #elif defined(__APPLE__)
@@ -293,14 +665,196 @@ void background_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_string(settings, "model_select", MODEL_MEDIAPIPE);
 	obs_data_set_default_int(settings, "mask_every_x_frames", 1);
 	obs_data_set_default_int(settings, "blur_background", 0);
-	obs_data_set_default_int(settings, "numThreads", 1);
+	// 0 shares the plugin's thread pool, sized to the CPU budget
+	obs_data_set_default_int(settings, "numThreads", 0);
+	obs_data_set_default_int(settings, "inference_resolution", 0);
+	obs_data_set_default_double(settings, "rvm_downsample_ratio", 0.0);
+	obs_data_set_default_int(settings, "warmup_runs", 2);
 	obs_data_set_default_bool(settings, "enable_focal_blur", false);
+	obs_data_set_default_bool(settings, "sync_output", false);
+	obs_data_set_default_bool(settings, "stats_overlay", false);
+	obs_data_set_default_bool(settings, "change_map", false);
 	obs_data_set_default_double(settings, "temporal_smooth_factor", 0.85);
 	obs_data_set_default_double(settings, "image_similarity_threshold",
 				    35.0);
 	obs_data_set_default_bool(settings, "enable_image_similarity", true);
 	obs_data_set_default_double(settings, "blur_focus_point", 0.1);
 	obs_data_set_default_double(settings, "blur_focus_depth", 0.0);
+	obs_data_set_default_bool(settings, "enable_depth_blur", false);
+	obs_data_set_default_int(settings, "depth_every_x_frames", 4);
+}
+
+/**
+  * @brief Request a session build in the background, unless the same model, device and
+  * threads (and source size, for models that run at its resolution) were already
+  * requested
+  *
+  * @return true if a new build was requested
+*/
+static bool requestSession(struct background_removal_filter *tf,
+			   const std::string &modelSelection,
+			   const std::string &useGPU, uint32_t numThreads,
+			   uint32_t inferenceShortSide, uint32_t warmupRuns)
+{
+	const ModelDescriptor *descriptor = findModelDescriptor(modelSelection);
+	if (!descriptor) {
+		obs_log(LOG_ERROR, "Model %s is not in the model registry",
+			modelSelection.c_str());
+		return false;
+	}
+
+	std::unique_ptr<ORTModelData> staged =
+		stageSession(*descriptor, useGPU, numThreads,
+			     inferenceShortSide, tf->rvmDownsampleRatio, tf->env);
+	if (!staged) {
+		return false;
+	}
+
+	std::string sessionKey = modelSelection + "|" + useGPU + "|" +
+				 std::to_string(numThreads) + "|" +
+				 std::to_string(inferenceShortSide) + "|" +
+				 std::to_string(tf->rvmDownsampleRatio);
+	if (staged->model->followsSourceResolution()) {
+		// Shaped and warmed up for the current source size, a new size gets a new
+		// session (see followSourceSize)
+		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
+		const cv::Size sourceSize = !tf->inputYUV.empty()
+						    ? tf->inputYUV.size()
+						    : tf->inputBGRA.size();
+		staged->sourceWidth = (uint32_t)sourceSize.width;
+		staged->sourceHeight = (uint32_t)sourceSize.height;
+		staged->rebuildsForSourceSize = true;
+		sessionKey += "|" + std::to_string(sourceSize.width) + "x" +
+			      std::to_string(sourceSize.height);
+	}
+	{
+		std::lock_guard<std::mutex> lock(tf->requestedSessionKeyLock);
+		if (tf->requestedSessionKey == sessionKey) {
+			return false;
+		}
+		tf->requestedSessionKey = sessionKey;
+	}
+
+	staged->warmupRuns = warmupRuns;
+	staged->requestTime = std::chrono::steady_clock::now();
+
+	tf->sessionBuilder->request(std::move(staged));
+	return true;
+}
+
+/**
+  * @brief Request the depth session of the depth blur in the background, on the same
+  * device and threads as the segmentation session, or release it when not needed
+*/
+static void requestDepthSession(struct background_removal_filter *tf,
+				bool enabled, const std::string &useGPU,
+				uint32_t numThreads, uint32_t warmupRuns)
+{
+	const std::string sessionKey =
+		enabled ? useGPU + "|" + std::to_string(numThreads) : "";
+	{
+		std::lock_guard<std::mutex> lock(tf->requestedSessionKeyLock);
+		if (tf->requestedDepthSessionKey == sessionKey) {
+			return;
+		}
+		tf->requestedDepthSessionKey = sessionKey;
+	}
+
+	if (!enabled) {
+		ORTModelData released;
+		{
+			std::lock_guard<std::mutex> lock(tf->depthMutex);
+			tf->depth.swapSession(released);
+		}
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		tf->depthMap.release();
+		return;
+	}
+
+	const ModelDescriptor *descriptor =
+		findModelDescriptor(MODEL_DEPTH_TCMONODEPTH);
+	if (!descriptor) {
+		obs_log(LOG_ERROR, "Model %s is not in the model registry",
+			MODEL_DEPTH_TCMONODEPTH);
+		return;
+	}
+
+	std::unique_ptr<ORTModelData> staged(new ORTModelData);
+	staged->modelSelection = MODEL_DEPTH_TCMONODEPTH;
+	staged->useGPU = useGPU;
+	staged->numThreads = numThreads;
+	staged->warmupRuns = warmupRuns;
+	staged->requestTime = std::chrono::steady_clock::now();
+	staged->env = tf->env;
+	staged->model = createModel(*descriptor);
+	if (!staged->model) {
+		return;
+	}
+
+	tf->depthSessionBuilder->request(std::move(staged));
+}
+
+/**
+  * @brief Set the performance settings to the configuration tuned for the model on
+  * this machine, if any
+*/
+static void applyTunedConfig(obs_data_t *settings, const std::string &model)
+{
+	TuneConfig tuned;
+	if (!loadTunedConfig(model, tuned)) {
+		return;
+	}
+	if (isExecutionProviderAvailable(tuned.useGPU)) {
+		obs_data_set_string(settings, "useGPU", tuned.useGPU.c_str());
+	}
+	obs_data_set_int(settings, "numThreads", tuned.numThreads);
+	obs_data_set_int(settings, "inference_resolution",
+			 tuned.inferenceShortSide);
+	obs_data_set_int(settings, "mask_every_x_frames",
+			 tuned.maskEveryXFrames);
+}
+
+/**
+  * @brief Reset the performance settings that are still at the configuration tuned
+  * for the model to their defaults
+*/
+static void clearTunedConfig(obs_data_t *settings, const std::string &model)
+{
+	TuneConfig tuned;
+	if (!loadTunedConfig(model, tuned)) {
+		return;
+	}
+	if (tuned.useGPU == obs_data_get_string(settings, "useGPU")) {
+		obs_data_unset_user_value(settings, "useGPU");
+	}
+	if ((int64_t)tuned.numThreads ==
+	    obs_data_get_int(settings, "numThreads")) {
+		obs_data_unset_user_value(settings, "numThreads");
+	}
+	if ((int64_t)tuned.inferenceShortSide ==
+	    obs_data_get_int(settings, "inference_resolution")) {
+		obs_data_unset_user_value(settings, "inference_resolution");
+	}
+	if ((int64_t)tuned.maskEveryXFrames ==
+	    obs_data_get_int(settings, "mask_every_x_frames")) {
+		obs_data_unset_user_value(settings, "mask_every_x_frames");
+	}
+}
+
+/**
+  * @brief Whether the settings have any saved user value. A filter that was just
+  * added has none, one loaded from a scene collection usually has some.
+*/
+static bool hasUserValues(obs_data_t *settings)
+{
+	for (obs_data_item_t *item = obs_data_first(settings); item;
+	     obs_data_item_next(&item)) {
+		if (obs_data_item_has_user_value(item)) {
+			obs_data_item_release(&item);
+			return true;
+		}
+	}
+	return false;
 }
 
 void background_filter_update(void *data, obs_data_t *settings)
@@ -309,7 +863,14 @@ void background_filter_update(void *data, obs_data_t *settings)
 	struct background_removal_filter *tf =
 		reinterpret_cast<background_removal_filter *>(data);
 
-	tf->isDisabled = true;
+	const std::string newModel =
+		obs_data_get_string(settings, "model_select");
+	if (newModel != tf->settingsModel) {
+		// The tuned performance settings follow the model
+		clearTunedConfig(settings, tf->settingsModel);
+		applyTunedConfig(settings, newModel);
+		tf->settingsModel = newModel;
+	}
 
 	tf->enableThreshold =
 		(float)obs_data_get_bool(settings, "enable_threshold");
@@ -320,6 +881,7 @@ void background_filter_update(void *data, obs_data_t *settings)
 	tf->smoothContour =
 		(float)obs_data_get_double(settings, "smooth_contour");
 	tf->feather = (float)obs_data_get_double(settings, "feather");
+	tf->maskUpscale = (int)obs_data_get_int(settings, "mask_upscale");
 	tf->maskEveryXFrames =
 		(int)obs_data_get_int(settings, "mask_every_x_frames");
 	tf->maskEveryXFramesCount = (int)(0);
@@ -330,62 +892,41 @@ void background_filter_update(void *data, obs_data_t *settings)
 		(float)obs_data_get_double(settings, "blur_focus_point");
 	tf->blurFocusDepth =
 		(float)obs_data_get_double(settings, "blur_focus_depth");
+	tf->depthEveryXFrames =
+		(int)obs_data_get_int(settings, "depth_every_x_frames");
+	tf->depthEveryXFramesCount = 0;
 	tf->temporalSmoothFactor =
 		(float)obs_data_get_double(settings, "temporal_smooth_factor");
+	tf->syncOutput = obs_data_get_bool(settings, "sync_output");
+	tf->statsOverlay = obs_data_get_bool(settings, "stats_overlay");
+	tf->enableChangeMap = obs_data_get_bool(settings, "change_map");
 	tf->imageSimilarityThreshold = (float)obs_data_get_double(
 		settings, "image_similarity_threshold");
 	tf->enableImageSimilarity =
 		(float)obs_data_get_bool(settings, "enable_image_similarity");
 
-	const std::string newUseGpu = obs_data_get_string(settings, "useGPU");
-	const std::string newModel =
-		obs_data_get_string(settings, "model_select");
+	const std::string newUseGpu = tf->resolveExecutionProvider(
+		obs_data_get_string(settings, "useGPU"));
 	const uint32_t newNumThreads =
 		(uint32_t)obs_data_get_int(settings, "numThreads");
-
-	if (tf->modelSelection.empty() || tf->modelSelection != newModel ||
-	    tf->useGPU != newUseGpu || tf->numThreads != newNumThreads) {
-		// lock modelMutex
-		std::unique_lock<std::mutex> lock(tf->modelMutex);
-
-		// Re-initialize model if it's not already the selected one or switching inference device
-		tf->modelSelection = newModel;
-		tf->useGPU = newUseGpu;
-		tf->numThreads = newNumThreads;
-
-		if (tf->modelSelection == MODEL_SINET) {
-			tf->model.reset(new ModelSINET);
-		}
-		if (tf->modelSelection == MODEL_SELFIE) {
-			tf->model.reset(new ModelSelfie);
-		}
-		if (tf->modelSelection == MODEL_MEDIAPIPE) {
-			tf->model.reset(new ModelMediaPipe);
-		}
-		if (tf->modelSelection == MODEL_RVM) {
-			tf->model.reset(new ModelRVM);
-		}
-		if (tf->modelSelection == MODEL_PPHUMANSEG) {
-			tf->model.reset(new ModelPPHumanSeg);
-		}
-		if (tf->modelSelection == MODEL_DEPTH_TCMONODEPTH) {
-			tf->model.reset(new ModelTCMonoDepth);
-		}
-		if (tf->modelSelection == MODEL_RMBG) {
-			tf->model.reset(new ModelRMBG);
-		}
-
-		int ortSessionResult = createOrtSession(tf);
-		if (ortSessionResult != OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
-			obs_log(LOG_ERROR,
-				"Failed to create ONNXRuntime session. Error code: %d",
-				ortSessionResult);
-			// disable filter
-			tf->isDisabled = true;
-			tf->model.reset();
-			return;
-		}
-	}
+	const uint32_t newInferenceShortSide =
+		(uint32_t)obs_data_get_int(settings, "inference_resolution");
+	tf->rvmDownsampleRatio =
+		(float)obs_data_get_double(settings, "rvm_downsample_ratio");
+
+	// Re-initialize model if it's not already the selected one or switching inference device.
+	// The session is built in the background while the current one keeps producing masks.
+	requestSession(tf, newModel, newUseGpu, newNumThreads,
+		       newInferenceShortSide,
+		       (uint32_t)obs_data_get_int(settings, "warmup_runs"));
+
+	// The depth blur needs a separate depth model, unless it is the selected model
+	tf->enableDepthBlur = tf->enableFocalBlur &&
+			      obs_data_get_bool(settings, "enable_depth_blur") &&
+			      newModel != MODEL_DEPTH_TCMONODEPTH;
+	requestDepthSession(
+		tf, tf->enableDepthBlur, newUseGpu, newNumThreads,
+		(uint32_t)obs_data_get_int(settings, "warmup_runs"));
 
 	obs_enter_graphics();
 
@@ -406,16 +947,25 @@ void background_filter_update(void *data, obs_data_t *settings)
 	obs_log(LOG_INFO, "Background Removal Filter Options:");
 	// name of the source that the filter is attached to
 	obs_log(LOG_INFO, "  Source: %s", obs_source_get_name(tf->source));
-	obs_log(LOG_INFO, "  Model: %s", tf->modelSelection.c_str());
-	obs_log(LOG_INFO, "  Inference Device: %s", tf->useGPU.c_str());
-	obs_log(LOG_INFO, "  Num Threads: %d", tf->numThreads);
+	obs_log(LOG_INFO, "  Model: %s", newModel.c_str());
+	obs_log(LOG_INFO, "  Inference Device: %s", newUseGpu.c_str());
+	obs_log(LOG_INFO, "  Num Threads: %d", newNumThreads);
+	obs_log(LOG_INFO, "  Inference Resolution: %d", newInferenceShortSide);
+	obs_log(LOG_INFO, "  RVM Downsample Ratio: %f", tf->rvmDownsampleRatio);
 	obs_log(LOG_INFO, "  Enable Threshold: %s",
 		tf->enableThreshold ? "true" : "false");
 	obs_log(LOG_INFO, "  Threshold: %f", tf->threshold);
 	obs_log(LOG_INFO, "  Contour Filter: %f", tf->contourFilter);
 	obs_log(LOG_INFO, "  Smooth Contour: %f", tf->smoothContour);
 	obs_log(LOG_INFO, "  Feather: %f", tf->feather);
+	obs_log(LOG_INFO, "  Mask Upscale: %d", tf->maskUpscale);
 	obs_log(LOG_INFO, "  Mask Every X Frames: %d", tf->maskEveryXFrames);
+	obs_log(LOG_INFO, "  Sync Output: %s",
+		tf->syncOutput ? "true" : "false");
+	obs_log(LOG_INFO, "  Stats Overlay: %s",
+		tf->statsOverlay ? "true" : "false");
+	obs_log(LOG_INFO, "  Change Map: %s",
+		tf->enableChangeMap ? "true" : "false");
 	obs_log(LOG_INFO, "  Enable Image Similarity: %s",
 		tf->enableImageSimilarity ? "true" : "false");
 	obs_log(LOG_INFO, "  Image Similarity Threshold: %f",
@@ -425,15 +975,10 @@ void background_filter_update(void *data, obs_data_t *settings)
 		tf->enableFocalBlur ? "true" : "false");
 	obs_log(LOG_INFO, "  Blur Focus Point: %f", tf->blurFocusPoint);
 	obs_log(LOG_INFO, "  Blur Focus Depth: %f", tf->blurFocusDepth);
+	obs_log(LOG_INFO, "  Enable Depth Blur: %s",
+		tf->enableDepthBlur ? "true" : "false");
+	obs_log(LOG_INFO, "  Depth Every X Frames: %d", tf->depthEveryXFrames);
 	obs_log(LOG_INFO, "  Disabled: %s", tf->isDisabled ? "true" : "false");
-#ifdef _WIN32
-	obs_log(LOG_INFO, "  Model file path: %S", tf->modelFilepath.c_str());
-#else
-	obs_log(LOG_INFO, "  Model file path: %s", tf->modelFilepath.c_str());
-#endif
-
-	// enable
-	tf->isDisabled = false;
 }
 
 void background_filter_activate(void *data)
@@ -454,6 +999,137 @@ void background_filter_deactivate(void *data)
 
 /**                   FILTER CORE                     */
 
+static void publishSession(struct background_removal_filter *tf,
+			   std::unique_ptr<ORTModelData> &built, int result)
+{
+	if (result != OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+		obs_log(LOG_ERROR,
+			"Failed to create ONNXRuntime session. Error code: %d",
+			result);
+		// Keep the current session (if any) serving
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		tf->swapSession(*built);
+	}
+
+	obs_log(LOG_INFO, "Background filter now using model %s on %s",
+		tf->modelSelection.c_str(), tf->activeProvider.c_str());
+#ifdef _WIN32
+	obs_log(LOG_INFO, "  Model file path: %S", tf->modelFilepath.c_str());
+#else
+	obs_log(LOG_INFO, "  Model file path: %s", tf->modelFilepath.c_str());
+#endif
+}
+
+// Procedures can't be removed from a proc handler, so "get_mask" is added once to
+// each parent source and looks up the filter that answers it. Filters remove
+// themselves when destroyed.
+static std::mutex maskProcMutex;
+static std::map<const obs_source_t *, background_removal_filter *>
+	maskProcFilters;
+static std::set<const obs_source_t *> maskProcParents;
+
+/**
+  * @brief Proc handler "get_mask" of the parent source, lets other plugins read the
+  * current mask
+  *
+  * void get_mask(in ptr buffer, in int buffer_size, out int width, out int height,
+  *               out int frame_time, out bool success)
+  *
+  * The mask is 8-bit single channel, 255 on the background, at the source or the
+  * network resolution (see the Mask upscaling setting). Call with a null buffer to
+  * get the size, the mask is copied only if buffer_size >= width * height.
+*/
+static void getMaskProc(void *data, calldata_t *cd)
+{
+	const obs_source_t *parent = (const obs_source_t *)data;
+
+	uint8_t *buffer = (uint8_t *)calldata_ptr(cd, "buffer");
+	const long long bufferSize = calldata_int(cd, "buffer_size");
+
+	bool success = false;
+	{
+		// Held while the mask is read, so the filter can't be destroyed meanwhile
+		std::lock_guard<std::mutex> procLock(maskProcMutex);
+		auto it = maskProcFilters.find(parent);
+		if (it == maskProcFilters.end()) {
+			calldata_set_int(cd, "width", 0);
+			calldata_set_int(cd, "height", 0);
+			calldata_set_int(cd, "frame_time", 0);
+			calldata_set_bool(cd, "success", false);
+			return;
+		}
+		struct background_removal_filter *tf = it->second;
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		const cv::Mat &mask = tf->backgroundMask;
+		calldata_set_int(cd, "width", mask.cols);
+		calldata_set_int(cd, "height", mask.rows);
+		calldata_set_int(cd, "frame_time",
+				 (long long)tf->backgroundMaskFrameTime);
+		if (!mask.empty() && buffer != nullptr &&
+		    bufferSize >= (long long)mask.total()) {
+			mask.copyTo(cv::Mat(mask.size(), CV_8UC1, buffer));
+			success = true;
+		}
+	}
+	calldata_set_bool(cd, "success", success);
+}
+
+static void maskProcParentDestroyed(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	// A new source at the same address needs the procedure again
+	const obs_source_t *parent =
+		(const obs_source_t *)calldata_ptr(cd, "source");
+	std::lock_guard<std::mutex> lock(maskProcMutex);
+	maskProcParents.erase(parent);
+	maskProcFilters.erase(parent);
+}
+
+/**
+  * @brief Answer "get_mask" on the parent source. The parent is only known once the
+  * filter is added to it, so this runs from the tick.
+*/
+static void registerMaskProc(struct background_removal_filter *tf)
+{
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	if (!parent || parent == tf->maskProcParent) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(maskProcMutex);
+	if (tf->maskProcParent) {
+		auto it = maskProcFilters.find(tf->maskProcParent);
+		if (it != maskProcFilters.end() && it->second == tf) {
+			maskProcFilters.erase(it);
+		}
+	}
+	tf->maskProcParent = parent;
+	maskProcFilters[parent] = tf;
+	if (maskProcParents.insert(parent).second) {
+		proc_handler_add(
+			obs_source_get_proc_handler(parent),
+			"void get_mask(in ptr buffer, in int buffer_size, out int width, out int height, out int frame_time, out bool success)",
+			getMaskProc, parent);
+		signal_handler_connect(obs_source_get_signal_handler(parent),
+				       "destroy", maskProcParentDestroyed,
+				       nullptr);
+	}
+}
+
+static void unregisterMaskProc(struct background_removal_filter *tf)
+{
+	std::lock_guard<std::mutex> lock(maskProcMutex);
+	auto it = maskProcFilters.find(tf->maskProcParent);
+	if (it != maskProcFilters.end() && it->second == tf) {
+		maskProcFilters.erase(it);
+	}
+	tf->maskProcParent = nullptr;
+}
+
 void *background_filter_create(obs_data_t *settings, obs_source_t *source)
 {
 	obs_log(LOG_INFO, "Background filter created");
@@ -461,14 +1137,38 @@ void *background_filter_create(obs_data_t *settings, obs_source_t *source)
 	struct background_removal_filter *tf = new (data)
 		background_removal_filter();
 
+	installMatAllocationCounter();
+
 	tf->source = source;
 	tf->texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
-
-	std::string instanceName{"background-removal-inference"};
-	tf->env.reset(new Ort::Env(OrtLoggingLevel::ORT_LOGGING_LEVEL_ERROR,
-				   instanceName.c_str()));
-
-	tf->modelSelection = MODEL_MEDIAPIPE;
+	// Camera frames are preprocessed from their YUV planes in the tick
+	tf->acceptsYuvInput = true;
+
+	tf->env = getSharedOrtEnv();
+
+	tf->sessionBuilder.reset(new OrtSessionBuilder(
+		[tf](std::unique_ptr<ORTModelData> &built, int result) {
+			publishSession(tf, built, result);
+		}));
+	tf->depthSessionBuilder.reset(new OrtSessionBuilder(
+		[tf](std::unique_ptr<ORTModelData> &built, int result) {
+			if (result != OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+				obs_log(LOG_ERROR,
+					"Failed to create the depth session. Error code: %d",
+					result);
+				return;
+			}
+			std::lock_guard<std::mutex> lock(tf->depthMutex);
+			tf->depth.swapSession(*built);
+		}));
+
+	// Only a new filter starts from the tuned configuration, existing ones keep their
+	// settings
+	if (!hasUserValues(settings)) {
+		applyTunedConfig(settings,
+				 obs_data_get_string(settings, "model_select"));
+	}
+	tf->settingsModel = obs_data_get_string(settings, "model_select");
 	background_filter_update(tf, settings);
 
 	return tf;
@@ -484,6 +1184,16 @@ void background_filter_destroy(void *data)
 	if (tf) {
 		tf->isDisabled = true;
 
+		tf->autoTuneCancelled = true;
+		if (tf->autoTuneThread.joinable()) {
+			tf->autoTuneThread.join();
+		}
+		// Stop the session builders first, they may still publish into tf
+		tf->sessionBuilder.reset();
+		tf->depthSessionBuilder.reset();
+		releaseSharedResults(tf);
+		unregisterMaskProc(tf);
+
 		obs_enter_graphics();
 		gs_texrender_destroy(tf->texrender);
 		if (tf->stagesurface) {
@@ -491,31 +1201,314 @@ void background_filter_destroy(void *data)
 		}
 		gs_effect_destroy(tf->effect);
 		gs_effect_destroy(tf->kawaseBlurEffect);
+		for (SyncFrame &frame : tf->syncFrames) {
+			gs_texture_destroy(frame.texture);
+		}
+		gs_texture_destroy(tf->statsTexture);
 		obs_leave_graphics();
 		tf->~background_removal_filter();
 		bfree(tf);
 	}
 }
 
-static void processImageForBackground(struct background_removal_filter *tf,
-				      const cv::Mat &imageBGRA,
-				      cv::Mat &backgroundMask)
+/**
+  * @brief Turn the model output into the background mask
+*/
+static void outputToBackgroundMask(struct background_removal_filter *tf,
+				   const cv::Mat &outputImage,
+				   cv::Mat &backgroundMask)
 {
-	cv::Mat outputImage;
-	if (!runFilterModelInference(tf, imageBGRA, outputImage)) {
-		return;
-	}
-	// Assume outputImage is now a single channel, uint8 image with values between 0 and 255
+	// Assume outputImage is a single channel, uint8 image with values between 0 and 255
 
 	// If we have a threshold, apply it. Otherwise, just use the output image as the mask
 	if (tf->enableThreshold) {
 		// We need to make tf->threshold (float [0,1]) be in that range
 		const uint8_t threshold_value =
 			(uint8_t)(tf->threshold * 255.0f);
-		backgroundMask = outputImage < threshold_value;
+		cv::compare(outputImage, threshold_value, backgroundMask,
+			    cv::CMP_LT);
 	} else {
-		backgroundMask = 255 - outputImage;
+		// 255 - outputImage
+		cv::bitwise_not(outputImage, backgroundMask);
+	}
+}
+
+/**
+  * @return true if backgroundMask holds the mask of the image
+*/
+template<typename Image>
+static bool processImageForBackground(struct background_removal_filter *tf,
+				      const Image &image,
+				      cv::Mat &backgroundMask)
+{
+	cv::Mat &outputImage = tf->modelOutput;
+	// Another filter on the source may have computed this frame's mask already
+	const std::string settingsKey =
+		std::to_string(tf->inferenceShortSide) + "|" +
+		std::to_string(tf->rvmDownsampleRatio);
+	if (!runSharedModelInference(tf, image, settingsKey, outputImage)) {
+		return false;
+	}
+	outputToBackgroundMask(tf, outputImage, backgroundMask);
+	return true;
+}
+
+/**
+  * @brief Decide from the change map whether the tick infers, and show it in the
+  * stats
+*/
+static ChangeDecision decideInference(struct background_removal_filter *tf,
+				      bool isYUV)
+{
+	const cv::Mat &image = isYUV ? yuvLuma(tf->frameYUV, tf->lumaScratch)
+				     : tf->frameBGRA;
+	const ChangeDecision decision =
+		updateChangeMap(tf->changeMap, image, tf->lastModelMask);
+
+	std::lock_guard<std::mutex> lock(tf->outputLock);
+	tf->changeMap.changed.copyTo(tf->stats.changedTiles);
+	return decision;
+}
+
+/**
+  * @brief Forget the change map when it is turned off or the model is recurrent, the
+  * next time it is used starts with a full inference
+*/
+static void clearChangeMap(struct background_removal_filter *tf)
+{
+	if (tf->changeMap.reference.empty()) {
+		return;
+	}
+	resetChangeMap(tf->changeMap);
+	tf->lastModelMask.release();
+
+	std::lock_guard<std::mutex> lock(tf->outputLock);
+	tf->stats.changedTiles.release();
+}
+
+/**
+  * @brief Remove the blobs of a binary mask smaller than an area, in place
+  *
+  * Blobs are the 8-connected components of the set pixels, measured by their pixel
+  * count. Unlike filling the outer contours of the kept blobs, holes inside them are
+  * preserved.
+  *
+  * @param mask The binary (0 or 255) CV_8UC1 mask
+  * @param minArea The area in pixels a blob must exceed to be kept
+*/
+static void filterSmallComponents(struct background_removal_filter *tf,
+				  cv::Mat &mask, double minArea)
+{
+	// OpenCV labels 8-connected components with its parallel Spaghetti algorithm
+	const int count = cv::connectedComponentsWithStats(
+		mask, tf->componentLabels, tf->componentStats,
+		tf->componentCentroids, 8, CV_32S);
+
+	// Output value of each label. Label 0 is the unset pixels.
+	std::vector<uint8_t> &values = tf->componentValues;
+	values.assign(count, 0);
+	for (int label = 1; label < count; label++) {
+		if (tf->componentStats.at<int>(label, cv::CC_STAT_AREA) >
+		    minArea) {
+			values[label] = 255;
+		}
+	}
+
+	const cv::Mat &labels = tf->componentLabels;
+	cv::parallel_for_(cv::Range(0, mask.rows), [&](const cv::Range &rows) {
+		for (int y = rows.start; y < rows.end; y++) {
+			const int *labelRow = labels.ptr<int>(y);
+			uint8_t *maskRow = mask.ptr<uint8_t>(y);
+			for (int x = 0; x < mask.cols; x++) {
+				maskRow[x] = values[labelRow[x]];
+			}
+		}
+	});
+}
+
+/**
+  * @brief Run the depth model on a frame and publish the depth map, on its own thread
+  * while the segmentation model runs on the tick thread
+*/
+template<typename Image>
+static void processImageForDepth(struct background_removal_filter *tf,
+				 const Image &image)
+{
+	try {
+		std::lock_guard<std::mutex> lock(tf->depthMutex);
+		// Another filter on the source may have estimated this frame's depth
+		if (!runSharedModelInference(tf, &tf->depth, image, "depth",
+					     tf->depthOutput)) {
+			// The depth session is still being built
+			return;
+		}
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Depth inference failed: %s", e.what());
+		return;
 	}
+	// Same orientation as a depth model selected as the segmentation model
+	cv::bitwise_not(tf->depthOutput, tf->depthOutput);
+
+	std::lock_guard<std::mutex> lock(tf->outputLock);
+	tf->depthOutput.copyTo(tf->depthMap);
+}
+
+/**
+  * @brief Publish the mask for the render thread, with how the shader samples it
+*/
+static void saveBackgroundMask(struct background_removal_filter *tf,
+			       const cv::Mat &mask, int upscale)
+{
+	// Under the lock, a size change reallocates the mask the render reads
+	std::lock_guard<std::mutex> lock(tf->outputLock);
+	mask.copyTo(tf->backgroundMask);
+	tf->backgroundMaskUpscale = upscale;
+	tf->backgroundMaskFrameTime = tf->frameTime;
+	recordMask(tf->stats);
+
+	if (tf->syncOutput) {
+		// Keep the recent masks, the delayed frames still need theirs
+		if (tf->syncMasks.empty()) {
+			tf->syncMasks.resize(SYNC_MAX_DELAY_FRAMES + 1);
+		}
+		SyncMask &syncMask = tf->syncMasks[tf->syncMaskNext];
+		tf->syncMaskNext = (tf->syncMaskNext + 1) % tf->syncMasks.size();
+		mask.copyTo(syncMask.mask);
+		syncMask.frameTime = tf->frameTime;
+		syncMask.upscale = upscale;
+	}
+}
+
+/**
+  * @brief Resize the thresholded network mask to the source size, then sharpen and
+  * feather its edge at full resolution
+*/
+static void finishMaskAtSourceResolution(struct background_removal_filter *tf,
+					 const cv::Mat &mask,
+					 const cv::Size &sourceSize)
+{
+	cv::resize(mask, tf->fullMask, sourceSize);
+
+	if (tf->smoothContour > 0.0) {
+		// If the mask was smoothed, apply a threshold to get a binary mask
+		cv::threshold(tf->fullMask, tf->fullMask, 128, 255,
+			      cv::THRESH_BINARY);
+	}
+
+	if (tf->feather > 0.0) {
+		// Feather (blur) the mask
+		int k_size = (int)(40 * tf->feather);
+		k_size += k_size % 2 == 0 ? 1 : 0;
+		cv::dilate(tf->fullMask, tf->maskScratch, cv::Mat(),
+			   cv::Point(-1, -1), k_size / 3);
+		cv::boxFilter(tf->maskScratch, tf->fullMask,
+			      tf->fullMask.depth(), cv::Size(k_size, k_size));
+	}
+
+	saveBackgroundMask(tf, tf->fullMask, MASK_UPSCALE_CPU);
+}
+
+/**
+  * @brief Keep the thresholded mask at network resolution, for the shader to upscale
+  *
+  * Without feathering the smoothed mask is uploaded as is and the shader rebuilds
+  * the edge. Feathering is done here with the kernel scaled to the network
+  * resolution, and the soft result is sampled bicubically.
+*/
+static void finishMaskAtNetworkResolution(struct background_removal_filter *tf,
+					  cv::Mat &mask,
+					  const cv::Size &sourceSize)
+{
+	if (tf->feather <= 0.0) {
+		saveBackgroundMask(tf, mask, tf->maskUpscale);
+		return;
+	}
+
+	if (tf->smoothContour > 0.0) {
+		cv::threshold(mask, mask, 128, 255, cv::THRESH_BINARY);
+	}
+
+	const double scale = (double)mask.cols / (double)sourceSize.width;
+	int k_size = std::max(1, (int)(40 * tf->feather * scale));
+	k_size += k_size % 2 == 0 ? 1 : 0;
+	cv::dilate(mask, tf->maskScratch, cv::Mat(), cv::Point(-1, -1),
+		   k_size / 3);
+	cv::boxFilter(tf->maskScratch, mask, mask.depth(),
+		      cv::Size(k_size, k_size));
+
+	saveBackgroundMask(tf, mask, MASK_UPSCALE_BICUBIC);
+}
+
+/**
+  * @brief Rebuild the session on the next execution provider in the fallback chain,
+  * after the current one failed at runtime
+*/
+static void fallbackToNextProvider(struct background_removal_filter *tf)
+{
+	std::string modelSelection, activeProvider;
+	uint32_t numThreads, inferenceShortSide, warmupRuns;
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		modelSelection = tf->modelSelection;
+		activeProvider = tf->activeProvider;
+		numThreads = tf->numThreads;
+		inferenceShortSide = tf->inferenceShortSide;
+		warmupRuns = tf->warmupRuns;
+	}
+	const std::string nextProvider =
+		getNextExecutionProvider(activeProvider);
+	if (nextProvider.empty()) {
+		return;
+	}
+	// Settings changes keep requesting it, until the device setting changes
+	tf->setFallbackProvider(nextProvider);
+	if (requestSession(tf, modelSelection, nextProvider, numThreads,
+			   inferenceShortSide, warmupRuns)) {
+		obs_log(LOG_WARNING,
+			"Execution provider %s failed at runtime, falling back to %s",
+			activeProvider.c_str(), nextProvider.c_str());
+	}
+}
+
+/**
+  * @brief Build a session for the new size in the background when the source of a
+  * model that runs at its resolution changes size. The current session keeps running
+  * at its own size until the new one is published.
+*/
+static void followSourceSize(struct background_removal_filter *tf,
+			     const cv::Size &frameSize)
+{
+	std::string modelSelection, useGPU;
+	uint32_t numThreads, inferenceShortSide, warmupRuns;
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		if (!tf->rebuildsForSourceSize ||
+		    (tf->sourceWidth == (uint32_t)frameSize.width &&
+		     tf->sourceHeight == (uint32_t)frameSize.height) ||
+		    frameSize == tf->followedSourceSize) {
+			return;
+		}
+		modelSelection = tf->modelSelection;
+		useGPU = tf->useGPU;
+		numThreads = tf->numThreads;
+		inferenceShortSide = tf->inferenceShortSide;
+		warmupRuns = tf->warmupRuns;
+	}
+	tf->followedSourceSize = frameSize;
+	if (requestSession(tf, modelSelection, useGPU, numThreads,
+			   inferenceShortSide, warmupRuns)) {
+		obs_log(LOG_INFO,
+			"Source size is now %dx%d, rebuilding the session of %s",
+			frameSize.width, frameSize.height,
+			modelSelection.c_str());
+	}
+}
+
+static void recordTickSkip(struct background_removal_filter *tf,
+			   SkipReason reason)
+{
+	std::lock_guard<std::mutex> lock(tf->outputLock);
+	recordSkip(tf->stats, reason);
 }
 
 void background_filter_video_tick(void *data, float seconds)
@@ -529,68 +1522,160 @@ void background_filter_video_tick(void *data, float seconds)
 		return;
 	}
 
+	registerMaskProc(tf);
+
 	if (!obs_source_enabled(tf->source)) {
 		return;
 	}
 
-	if (!tf->model) {
-		obs_log(LOG_ERROR, "Model is not initialized");
+	if (tf->autoTuning) {
+		// The last mask stays while the auto-tuner measures
+		recordTickSkip(tf, SKIP_REASON_AUTO_TUNING);
 		return;
 	}
 
-	cv::Mat imageBGRA;
+	// Recurrent models must see every frame whole
+	bool recurrent = false;
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		if (!tf->session) {
+			// The first session is still being built
+			recordTickSkip(tf, SKIP_REASON_NO_SESSION);
+			return;
+		}
+		recurrent = tf->model && tf->model->isRecurrent();
+	}
+
+	MatAllocationScope allocationScope("Background filter tick");
+
+	cv::Mat &imageBGRA = tf->frameBGRA;
+	YuvImage &imageYUV = tf->frameYUV;
+	bool hasFrame = false;
+	// Camera frames come in their YUV layout, rendered frames as BGRA
+	bool isYUV = false;
 	{
 		std::unique_lock<std::mutex> lock(tf->inputBGRALock,
 						  std::try_to_lock);
-		if (!lock.owns_lock()) {
-			// No data to process
-			return;
+		if (lock.owns_lock() && !tf->inputYUV.empty()) {
+			tf->inputYUV.copyTo(imageYUV);
+			isYUV = true;
+			hasFrame = true;
+		} else if (lock.owns_lock() && !tf->inputBGRA.empty()) {
+			tf->inputBGRA.copyTo(imageBGRA);
+			hasFrame = true;
 		}
-		if (tf->inputBGRA.empty()) {
-			// No data to process
-			return;
+		if (hasFrame) {
+			tf->frameTime = tf->inputFrameTime;
 		}
-		imageBGRA = tf->inputBGRA.clone();
 	}
+	if (!hasFrame) {
+		// No data to process
+		recordTickSkip(tf, SKIP_REASON_NO_FRAME);
+		return;
+	}
+	const cv::Size frameSize = isYUV ? imageYUV.size() : imageBGRA.size();
+	followSourceSize(tf, frameSize);
 
 	if (tf->enableImageSimilarity) {
-		if (!tf->lastImageBGRA.empty() && !imageBGRA.empty() &&
-		    tf->lastImageBGRA.size() == imageBGRA.size()) {
+		// The luma is enough to tell the frames apart
+		const cv::Mat &similarityImage =
+			isYUV ? yuvLuma(imageYUV, tf->lumaScratch) : imageBGRA;
+		if (!tf->lastSimilarityImage.empty() &&
+		    tf->lastSimilarityImage.size() == similarityImage.size() &&
+		    tf->lastSimilarityImage.type() == similarityImage.type()) {
 			// calculate PSNR
-			double psnr = cv::PSNR(tf->lastImageBGRA, imageBGRA);
+			double psnr =
+				cv::PSNR(tf->lastSimilarityImage, similarityImage);
 
 			if (psnr > tf->imageSimilarityThreshold) {
 				// The image is almost the same as the previous one. Skip processing.
+				recordTickSkip(tf, SKIP_REASON_SIMILAR_FRAME);
 				return;
 			}
 		}
-		tf->lastImageBGRA = imageBGRA.clone();
+		similarityImage.copyTo(tf->lastSimilarityImage);
 	}
 
-	if (tf->backgroundMask.empty()) {
-		// First frame. Initialize the background mask.
-		tf->backgroundMask =
-			cv::Mat(imageBGRA.size(), CV_8UC1, cv::Scalar(255));
+	{
+		// The render reads the mask under the lock
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		if (tf->backgroundMask.empty()) {
+			// First frame. Initialize the background mask.
+			tf->backgroundMask =
+				cv::Mat(frameSize, CV_8UC1, cv::Scalar(255));
+		}
 	}
 
 	tf->maskEveryXFramesCount++;
 	tf->maskEveryXFramesCount %= tf->maskEveryXFrames;
 
+	// Depth changes slowly, it runs every few frames next to the segmentation.
+	// The future waits for it when the tick returns.
+	std::future<void> depthDone;
+	if (tf->enableDepthBlur) {
+		tf->depthEveryXFramesCount++;
+		tf->depthEveryXFramesCount %= tf->depthEveryXFrames;
+		if (tf->depthEveryXFramesCount == 0) {
+			depthDone = std::async(std::launch::async, [tf, isYUV] {
+				applyThreadPlacement();
+				if (isYUV) {
+					processImageForDepth(tf, tf->frameYUV);
+				} else {
+					processImageForDepth(tf, tf->frameBGRA);
+				}
+			});
+		}
+	}
+
 	try {
 		if (tf->maskEveryXFramesCount != 0 &&
 		    !tf->backgroundMask.empty()) {
 			// We are skipping processing of the mask for this frame.
 			// Get the background mask previously generated.
-			; // Do nothing
+			recordTickSkip(tf, SKIP_REASON_MASK_INTERVAL);
 		} else {
-			cv::Mat backgroundMask;
+			cv::Mat &backgroundMask = tf->networkMask;
+
+			// Only a frame that moved near the mask edge needs a new mask
+			ChangeDecision decision = CHANGE_DECISION_FULL;
+			if (tf->enableChangeMap && !recurrent) {
+				decision = decideInference(tf, isYUV);
+			} else {
+				clearChangeMap(tf);
+			}
+			if (decision == CHANGE_DECISION_SKIP) {
+				recordTickSkip(tf, SKIP_REASON_STATIC_EDGE);
+				return;
+			}
 
+			double inferenceMs;
+			std::string provider;
+			bool inferred;
 			{
 				std::unique_lock<std::mutex> lock(
 					tf->modelMutex);
 				// Process the image to find the mask.
-				processImageForBackground(tf, imageBGRA,
-							  backgroundMask);
+				const auto inferenceStart =
+					std::chrono::steady_clock::now();
+				if (isYUV) {
+					inferred = processImageForBackground(
+						tf, imageYUV, backgroundMask);
+				} else {
+					inferred = processImageForBackground(
+						tf, imageBGRA, backgroundMask);
+				}
+				inferenceMs =
+					std::chrono::duration<double, std::milli>(
+						std::chrono::steady_clock::now() -
+						inferenceStart)
+						.count();
+				provider = tf->activeProvider;
+			}
+			{
+				std::lock_guard<std::mutex> lock(
+					tf->outputLock);
+				recordInference(tf->stats, inferenceMs,
+						provider);
 			}
 
 			if (backgroundMask.empty()) {
@@ -600,6 +1685,13 @@ void background_filter_video_tick(void *data, float seconds)
 				return;
 			}
 
+			if (tf->enableChangeMap && !recurrent && inferred) {
+				// Changes are measured from the frame the mask was inferred on,
+				// a failed inference keeps them
+				commitChangeMap(tf->changeMap);
+				backgroundMask.copyTo(tf->lastModelMask);
+			}
+
 			// Temporal smoothing
 			if (tf->temporalSmoothFactor > 0.0 &&
 			    tf->temporalSmoothFactor < 1.0 &&
@@ -623,35 +1715,17 @@ void background_filter_video_tick(void *data, float seconds)
 						backgroundMask);
 			}
 
-			tf->lastBackgroundMask = backgroundMask.clone();
+			backgroundMask.copyTo(tf->lastBackgroundMask);
 
 			// Contour processing
 			// Only applicable if we are thresholding (and get a binary image)
 			if (tf->enableThreshold) {
 				if (tf->contourFilter > 0.0 &&
 				    tf->contourFilter < 1.0) {
-					std::vector<std::vector<cv::Point>>
-						contours;
-					findContours(backgroundMask, contours,
-						     cv::RETR_EXTERNAL,
-						     cv::CHAIN_APPROX_SIMPLE);
-					std::vector<std::vector<cv::Point>>
-						filteredContours;
-					const double contourSizeThreshold =
+					filterSmallComponents(
+						tf, backgroundMask,
 						(double)(backgroundMask.total()) *
-						tf->contourFilter;
-					for (auto &contour : contours) {
-						if (cv::contourArea(contour) >
-						    (double)contourSizeThreshold) {
-							filteredContours
-								.push_back(
-									contour);
-						}
-					}
-					backgroundMask.setTo(0);
-					drawContours(backgroundMask,
-						     filteredContours, -1,
-						     cv::Scalar(255), -1);
+							tf->contourFilter);
 				}
 
 				if (tf->smoothContour > 0.0) {
@@ -664,37 +1738,27 @@ void background_filter_video_tick(void *data, float seconds)
 						      cv::Size(k_size, k_size));
 				}
 
-				// Resize the size of the mask back to the size of the original input.
-				cv::resize(backgroundMask, backgroundMask,
-					   imageBGRA.size());
-
-				// Additional contour processing at full resolution
-				if (tf->smoothContour > 0.0) {
-					// If the mask was smoothed, apply a threshold to get a binary mask
-					backgroundMask = backgroundMask > 128;
-				}
-
-				if (tf->feather > 0.0) {
-					// Feather (blur) the mask
-					int k_size = (int)(40 * tf->feather);
-					k_size += k_size % 2 == 0 ? 1 : 0;
-					cv::dilate(backgroundMask,
-						   backgroundMask, cv::Mat(),
-						   cv::Point(-1, -1),
-						   k_size / 3);
-					cv::boxFilter(
-						backgroundMask, backgroundMask,
-						tf->backgroundMask.depth(),
-						cv::Size(k_size, k_size));
+				if (tf->maskUpscale == MASK_UPSCALE_CPU) {
+					finishMaskAtSourceResolution(
+						tf, backgroundMask,
+						frameSize);
+				} else {
+					finishMaskAtNetworkResolution(
+						tf, backgroundMask,
+						frameSize);
 				}
+			} else {
+				// A soft mask, only the bicubic reconstruction applies
+				saveBackgroundMask(
+					tf, backgroundMask,
+					tf->maskUpscale == MASK_UPSCALE_CPU
+						? MASK_UPSCALE_CPU
+						: MASK_UPSCALE_BICUBIC);
 			}
-
-			// Save the mask for the next frame
-			backgroundMask.copyTo(tf->backgroundMask);
 		}
 	} catch (const Ort::Exception &e) {
 		obs_log(LOG_ERROR, "ONNXRuntime Exception: %s", e.what());
-		// TODO: Fall back to CPU if it makes sense
+		fallbackToNextProvider(tf);
 	} catch (const std::exception &e) {
 		obs_log(LOG_ERROR, "%s", e.what());
 	}
@@ -702,15 +1766,15 @@ void background_filter_video_tick(void *data, float seconds)
 
 static gs_texture_t *blur_background(struct background_removal_filter *tf,
 				     uint32_t width, uint32_t height,
-				     gs_texture_t *alphaTexture)
+				     gs_texture_t *alphaTexture,
+				     gs_texture_t *frameTexture)
 {
 	if (tf->blurBackground == 0 || !tf->kawaseBlurEffect) {
 		return nullptr;
 	}
 	gs_texture_t *blurredTexture =
 		gs_texture_create(width, height, GS_BGRA, 1, nullptr, 0);
-	gs_copy_texture(blurredTexture,
-			gs_texrender_get_texture(tf->texrender));
+	gs_copy_texture(blurredTexture, frameTexture);
 	gs_eparam_t *image =
 		gs_effect_get_param_by_name(tf->kawaseBlurEffect, "image");
 	gs_eparam_t *focalmask =
@@ -767,6 +1831,242 @@ static gs_texture_t *blur_background(struct background_removal_filter *tf,
 	return blurredTexture;
 }
 
+/**
+  * @brief Hold back the frame just read back, and return the one to output
+  *
+  * The queue keeps syncDelayFrames frames besides the new one. While it fills up
+  * after the delay grew, the oldest frame is output. OBS renders the filter once
+  * per view (preview, program, projectors), so a frame is held back only on the
+  * first render of a video frame. The other renders output the same frame.
+*/
+static SyncFrame pushSyncFrame(struct background_removal_filter *tf,
+			       uint32_t width, uint32_t height)
+{
+	const uint64_t renderTime = obs_get_video_frame_time();
+	if (renderTime == tf->syncRenderTime && !tf->syncFrames.empty()) {
+		return tf->syncFrames.back();
+	}
+	tf->syncRenderTime = renderTime;
+
+	SyncFrame frame;
+	if (tf->syncFrames.size() > tf->syncDelayFrames) {
+		frame = tf->syncFrames.back();
+		tf->syncFrames.pop_back();
+	}
+	while (tf->syncFrames.size() > tf->syncDelayFrames) {
+		gs_texture_destroy(tf->syncFrames.back().texture);
+		tf->syncFrames.pop_back();
+	}
+	if (frame.texture && (gs_texture_get_width(frame.texture) != width ||
+			      gs_texture_get_height(frame.texture) != height)) {
+		gs_texture_destroy(frame.texture);
+		frame.texture = nullptr;
+	}
+	if (!frame.texture) {
+		frame.texture =
+			gs_texture_create(width, height, GS_BGRA, 1, nullptr, 0);
+	}
+	gs_copy_texture(frame.texture, gs_texrender_get_texture(tf->texrender));
+	frame.frameTime = tf->inputFrameTime;
+	tf->syncFrames.push_front(frame);
+	return tf->syncFrames.back();
+}
+
+static void releaseSyncFrames(struct background_removal_filter *tf)
+{
+	for (SyncFrame &frame : tf->syncFrames) {
+		gs_texture_destroy(frame.texture);
+	}
+	tf->syncFrames.clear();
+	tf->syncRenderTime = 0;
+}
+
+/**
+  * @brief Measure how many frames after its frame a new mask is ready, and set the
+  * output delay to cover it
+  *
+  * The delay grows as soon as a mask arrives late, and shrinks only to the largest
+  * latency of a whole window of masks, so it doesn't follow jitter. Called with
+  * outputLock held.
+*/
+static void measureSyncLatency(struct background_removal_filter *tf)
+{
+	if (tf->backgroundMaskFrameTime <= tf->syncLastMaskFrameTime) {
+		return;
+	}
+	tf->syncLastMaskFrameTime = tf->backgroundMaskFrameTime;
+
+	const uint64_t interval = obs_get_frame_interval_ns();
+	const uint64_t now = obs_get_video_frame_time();
+	if (interval == 0 || now <= tf->backgroundMaskFrameTime) {
+		return;
+	}
+	const uint64_t latency = now - tf->backgroundMaskFrameTime;
+	tf->syncWindowMaxLatency = std::max(tf->syncWindowMaxLatency, latency);
+	tf->syncWindowCount++;
+
+	uint32_t delayFrames = tf->syncDelayFrames;
+	const uint32_t latencyFrames = (uint32_t)std::min<uint64_t>(
+		(latency + interval - 1) / interval, SYNC_MAX_DELAY_FRAMES);
+	if (latencyFrames > delayFrames) {
+		delayFrames = latencyFrames;
+	} else if (tf->syncWindowCount >= SYNC_LATENCY_WINDOW) {
+		delayFrames = (uint32_t)std::min<uint64_t>(
+			(tf->syncWindowMaxLatency + interval - 1) / interval,
+			SYNC_MAX_DELAY_FRAMES);
+		delayFrames = std::max(delayFrames, 1u);
+		tf->syncWindowMaxLatency = 0;
+		tf->syncWindowCount = 0;
+	}
+
+	if (delayFrames != tf->syncDelayFrames) {
+		tf->syncDelayFrames = delayFrames;
+		obs_log(LOG_INFO,
+			"Sync output delay of %s is now %u frames (%.0f ms)",
+			obs_source_get_name(tf->source), delayFrames,
+			(double)(delayFrames * interval) / 1e6);
+	}
+}
+
+/**
+  * @brief The most recent mask computed from a frame no newer than frameTime, the
+  * current mask if none is kept. Called with outputLock held.
+*/
+static const SyncMask *findSyncMask(struct background_removal_filter *tf,
+				    uint64_t frameTime)
+{
+	const SyncMask *found = nullptr;
+	for (const SyncMask &syncMask : tf->syncMasks) {
+		if (!syncMask.mask.empty() && syncMask.frameTime <= frameTime &&
+		    (!found || syncMask.frameTime > found->frameTime)) {
+			found = &syncMask;
+		}
+	}
+	return found;
+}
+
+/**
+  * @brief Rasterize the stats text, white on a translucent box
+*/
+static cv::Mat renderStatsText(const std::string &text)
+{
+	const int font = cv::FONT_HERSHEY_SIMPLEX;
+	const double scale = 0.45;
+	const int lineHeight = 18;
+	const int margin = 6;
+
+	std::vector<std::string> lines;
+	std::stringstream stream(text);
+	std::string line;
+	int width = 0;
+	while (std::getline(stream, line)) {
+		int baseline;
+		width = std::max(width,
+				 cv::getTextSize(line, font, scale, 1, &baseline)
+					 .width);
+		lines.push_back(line);
+	}
+
+	cv::Mat image((int)lines.size() * lineHeight + 2 * margin,
+		      width + 2 * margin, CV_8UC4, cv::Scalar(0, 0, 0, 160));
+	for (size_t i = 0; i < lines.size(); i++) {
+		cv::putText(image, lines[i],
+			    cv::Point(margin, margin + (int)(i + 1) * lineHeight -
+						      5),
+			    font, scale, cv::Scalar(255, 255, 255, 255), 1,
+			    cv::LINE_AA);
+	}
+	return image;
+}
+
+/**
+  * @brief Draw the debug overlay over the filter output
+  *
+  * The counters are the ones shown in the properties, only formatting and drawing
+  * them costs anything, and only while the overlay is on.
+*/
+static void drawStatsOverlay(struct background_removal_filter *tf,
+			     uint32_t width, uint32_t height)
+{
+	const auto now = std::chrono::steady_clock::now();
+	const bool redrawText = !tf->statsTexture ||
+				now - tf->statsTextureTime >=
+					STATS_OVERLAY_REFRESH;
+	std::string text;
+	gs_texture_t *tilesTexture = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		if (redrawText) {
+			const uint64_t interval = obs_get_frame_interval_ns();
+			const uint64_t frameTime = obs_get_video_frame_time();
+			const uint64_t maskAge =
+				frameTime > tf->backgroundMaskFrameTime &&
+						interval > 0
+					? (frameTime -
+					   tf->backgroundMaskFrameTime) /
+						  interval
+					: 0;
+			text = formatFilterStats(tf->stats) +
+			       "\nMask age: " + std::to_string(maskAge) +
+			       " frames";
+		}
+		const cv::Mat &tiles = tf->stats.changedTiles;
+		if (!tiles.empty()) {
+			tilesTexture = gs_texture_create(
+				tiles.cols, tiles.rows, GS_R8, 1,
+				(const uint8_t **)&tiles.data, 0);
+		}
+	}
+
+	if (redrawText) {
+		const cv::Mat image = renderStatsText(text);
+		gs_texture_destroy(tf->statsTexture);
+		tf->statsTexture = gs_texture_create(image.cols, image.rows,
+						     GS_BGRA, 1,
+						     (const uint8_t **)&image.data,
+						     0);
+		tf->statsTextureTime = now;
+	}
+	if (!tf->statsTexture) {
+		gs_texture_destroy(tilesTexture);
+		return;
+	}
+
+	struct vec4 statsRect;
+	vec4_set(&statsRect, 0.0f, 0.0f,
+		 (float)gs_texture_get_width(tf->statsTexture) / (float)width,
+		 (float)gs_texture_get_height(tf->statsTexture) /
+			 (float)height);
+
+	gs_effect_set_texture(
+		gs_effect_get_param_by_name(tf->effect, "statsText"),
+		tf->statsTexture);
+	gs_effect_set_vec4(gs_effect_get_param_by_name(tf->effect, "statsRect"),
+			   &statsRect);
+	gs_effect_set_texture(
+		gs_effect_get_param_by_name(tf->effect, "changedTiles"),
+		tilesTexture);
+	gs_effect_set_int(
+		gs_effect_get_param_by_name(tf->effect, "hasChangedTiles"),
+		tilesTexture ? 1 : 0);
+
+	gs_enable_blending(true);
+	gs_blend_function(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA);
+	while (gs_effect_loop(tf->effect, "DrawStatsOverlay")) {
+		gs_draw_sprite(nullptr, 0, width, height);
+	}
+
+	gs_texture_destroy(tilesTexture);
+}
+
+struct obs_source_frame *background_filter_video(void *data,
+						 struct obs_source_frame *frame)
+{
+	struct background_removal_filter *tf =
+		reinterpret_cast<background_removal_filter *>(data);
+	return filterAsyncVideo(tf, frame);
+}
+
 void background_filter_video_render(void *data, gs_effect_t *_effect)
 {
 	UNUSED_PARAMETER(_effect);
@@ -781,8 +2081,10 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 		return;
 	}
 
+	// The blur and the sync mode use the frame in tf->texrender
 	uint32_t width, height;
-	if (!getRGBAFromStageSurface(tf, width, height)) {
+	if (!getInputFrame(tf, width, height,
+			   tf->syncOutput || tf->blurBackground > 0)) {
 		if (tf->source) {
 			obs_source_skip_video_filter(tf->source);
 		}
@@ -797,12 +2099,41 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 		return;
 	}
 
+	// In sync mode a held back frame is output, instead of the one just read back
+	SyncFrame syncFrame;
+	if (tf->syncOutput) {
+		syncFrame = pushSyncFrame(tf, width, height);
+	} else if (!tf->syncFrames.empty()) {
+		releaseSyncFrames(tf);
+	}
+
 	gs_texture_t *alphaTexture = nullptr;
+	gs_texture_t *depthTexture = nullptr;
+	int maskUpscale;
+	struct vec2 maskTexelSize;
 	{
 		std::lock_guard<std::mutex> lock(tf->outputLock);
-		alphaTexture = gs_texture_create(
-			tf->backgroundMask.cols, tf->backgroundMask.rows, GS_R8,
-			1, (const uint8_t **)&tf->backgroundMask.data, 0);
+		if (tf->backgroundMask.empty()) {
+			// No mask yet (the session is still being built)
+			if (tf->source) {
+				obs_source_skip_video_filter(tf->source);
+			}
+			return;
+		}
+		const cv::Mat *mask = &tf->backgroundMask;
+		maskUpscale = tf->backgroundMaskUpscale;
+		if (syncFrame.texture) {
+			measureSyncLatency(tf);
+			const SyncMask *syncMask =
+				findSyncMask(tf, syncFrame.frameTime);
+			if (syncMask) {
+				mask = &syncMask->mask;
+				maskUpscale = syncMask->upscale;
+			}
+		}
+		alphaTexture = gs_texture_create(mask->cols, mask->rows, GS_R8,
+						 1, (const uint8_t **)&mask->data,
+						 0);
 		if (!alphaTexture) {
 			obs_log(LOG_ERROR, "Failed to create alpha texture");
 			if (tf->source) {
@@ -810,18 +2141,35 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 			}
 			return;
 		}
+		vec2_set(&maskTexelSize, 1.0f / (float)mask->cols,
+			 1.0f / (float)mask->rows);
+
+		// The depth map drives the focal blur, the mask the composite
+		if (tf->enableDepthBlur && tf->blurBackground > 0 &&
+		    !tf->depthMap.empty()) {
+			depthTexture = gs_texture_create(
+				tf->depthMap.cols, tf->depthMap.rows, GS_R8, 1,
+				(const uint8_t **)&tf->depthMap.data, 0);
+		}
 	}
 
 	// Output the masked image
-	gs_texture_t *blurredTexture =
-		blur_background(tf, width, height, alphaTexture);
+	gs_texture_t *frameTexture = syncFrame.texture;
+	if (!frameTexture) {
+		frameTexture = gs_texrender_get_texture(tf->texrender);
+	}
+	gs_texture_t *blurredTexture = blur_background(
+		tf, width, height, depthTexture ? depthTexture : alphaTexture,
+		frameTexture);
 
-	if (!obs_source_process_filter_begin(tf->source, GS_RGBA,
+	if (!syncFrame.texture &&
+	    !obs_source_process_filter_begin(tf->source, GS_RGBA,
 					     OBS_ALLOW_DIRECT_RENDERING)) {
 		if (tf->source) {
 			obs_source_skip_video_filter(tf->source);
 		}
 		gs_texture_destroy(alphaTexture);
+		gs_texture_destroy(depthTexture);
 		gs_texture_destroy(blurredTexture);
 		return;
 	}
@@ -831,7 +2179,14 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 	gs_eparam_t *blurredBackground =
 		gs_effect_get_param_by_name(tf->effect, "blurredBackground");
 
+	gs_eparam_t *maskUpscaleParam =
+		gs_effect_get_param_by_name(tf->effect, "maskUpscale");
+	gs_eparam_t *maskTexelSizeParam =
+		gs_effect_get_param_by_name(tf->effect, "maskTexelSize");
+
 	gs_effect_set_texture(alphamask, alphaTexture);
+	gs_effect_set_int(maskUpscaleParam, maskUpscale);
+	gs_effect_set_vec2(maskTexelSizeParam, &maskTexelSize);
 
 	if (tf->blurBackground > 0) {
 		gs_effect_set_texture(blurredBackground, blurredTexture);
@@ -842,7 +2197,9 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 
 	const char *techName;
 	if (tf->blurBackground > 0) {
-		if (tf->enableFocalBlur)
+		if (depthTexture)
+			techName = "DrawWithMaskAndBlur";
+		else if (tf->enableFocalBlur)
 			techName = "DrawWithFocalBlur";
 		else
 			techName = "DrawWithBlur";
@@ -850,11 +2207,25 @@ void background_filter_video_render(void *data, gs_effect_t *_effect)
 		techName = "DrawWithoutBlur";
 	}
 
-	obs_source_process_filter_tech_end(tf->source, tf->effect, 0, 0,
-					   techName);
+	if (syncFrame.texture) {
+		gs_eparam_t *image =
+			gs_effect_get_param_by_name(tf->effect, "image");
+		gs_effect_set_texture(image, syncFrame.texture);
+		while (gs_effect_loop(tf->effect, techName)) {
+			gs_draw_sprite(syncFrame.texture, 0, width, height);
+		}
+	} else {
+		obs_source_process_filter_tech_end(tf->source, tf->effect, 0,
+						   0, techName);
+	}
+
+	if (tf->statsOverlay) {
+		drawStatsOverlay(tf, width, height);
+	}
 
 	gs_blend_state_pop();
 
 	gs_texture_destroy(alphaTexture);
+	gs_texture_destroy(depthTexture);
 	gs_texture_destroy(blurredTexture);
 }
@@ -14,6 +14,8 @@ void background_filter_activate(void *data);
 void background_filter_deactivate(void *data);
 void background_filter_video_tick(void *data, float seconds);
 void background_filter_video_render(void *data, gs_effect_t *_effect);
+struct obs_source_frame *background_filter_video(void *data,
+						 struct obs_source_frame *frame);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,163 @@
+#include "cpu-budget.h"
+
+#include <obs-module.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "plugin-support.h"
+
+#ifdef _WIN32
+static uint32_t getAffinityCpuCount()
+{
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask,
+				    &systemMask)) {
+		return 0;
+	}
+	uint32_t count = 0;
+	for (; processMask != 0; processMask &= processMask - 1) {
+		count++;
+	}
+	return count;
+}
+
+/**
+  * @brief CPUs' worth of the hard CPU rate cap of the job object, 0 if none
+*/
+static double getQuotaCpuLimit(uint32_t cpuCount)
+{
+	JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rateControl;
+	if (!QueryInformationJobObject(nullptr,
+				       JobObjectCpuRateControlInformation,
+				       &rateControl, sizeof(rateControl),
+				       nullptr)) {
+		return 0.0;
+	}
+	if (!(rateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE) ||
+	    !(rateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP)) {
+		return 0.0;
+	}
+	// The rate is in 1/100 of a percent of all the CPUs
+	return (double)rateControl.CpuRate / 10000.0 * (double)cpuCount;
+}
+#elif defined(__linux__)
+static uint32_t getAffinityCpuCount()
+{
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+		return 0;
+	}
+	return (uint32_t)CPU_COUNT(&cpuSet);
+}
+
+/**
+  * @brief The cgroup v2 path of the process, empty on cgroup v1
+*/
+static std::string getCgroupPath()
+{
+	std::ifstream cgroups("/proc/self/cgroup");
+	std::string line;
+	while (std::getline(cgroups, line)) {
+		if (line.rfind("0::", 0) == 0) {
+			return line.substr(3);
+		}
+	}
+	return "";
+}
+
+/**
+  * @brief CPUs' worth of the cgroup CPU quota, 0 if unlimited
+  *
+  * On cgroup v2 the quotas of all the ancestors apply, the tightest one wins.
+*/
+static double getQuotaCpuLimit(uint32_t cpuCount)
+{
+	(void)cpuCount;
+	double limit = 0.0;
+	std::string path = getCgroupPath();
+	while (!path.empty()) {
+		std::ifstream cpuMax("/sys/fs/cgroup" + path + "/cpu.max");
+		std::string quota;
+		double period;
+		if (cpuMax >> quota >> period && quota != "max" &&
+		    period > 0.0) {
+			const double cgroupLimit = std::stod(quota) / period;
+			limit = limit > 0.0 ? std::min(limit, cgroupLimit)
+					    : cgroupLimit;
+		}
+		if (path == "/") {
+			break;
+		}
+		const size_t parent = path.find_last_of('/');
+		path = parent == 0 ? "/" : path.substr(0, parent);
+	}
+	if (limit > 0.0) {
+		return limit;
+	}
+
+	std::ifstream quotaFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+	std::ifstream periodFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+	double quotaUs, periodUs;
+	if (quotaFile >> quotaUs && periodFile >> periodUs && quotaUs > 0.0 &&
+	    periodUs > 0.0) {
+		return quotaUs / periodUs;
+	}
+	return 0.0;
+}
+#else
+static uint32_t getAffinityCpuCount()
+{
+	// No process affinity on macOS
+	return 0;
+}
+
+static double getQuotaCpuLimit(uint32_t cpuCount)
+{
+	(void)cpuCount;
+	return 0.0;
+}
+#endif
+
+static uint32_t computeUsableCpuCount()
+{
+	const uint32_t onlineCount =
+		std::max(1u, (uint32_t)std::thread::hardware_concurrency());
+	uint32_t usable = onlineCount;
+
+	const uint32_t affinityCount = getAffinityCpuCount();
+	if (affinityCount > 0) {
+		usable = std::min(usable, affinityCount);
+	}
+	const double quota = getQuotaCpuLimit(onlineCount);
+	if (quota > 0.0) {
+		usable = std::min(usable,
+				  std::max(1u, (uint32_t)std::ceil(quota)));
+	}
+
+	obs_log(LOG_INFO,
+		"Usable CPUs: %u (%u online, affinity %u, quota %.2f)", usable,
+		onlineCount, affinityCount, quota);
+	return usable;
+}
+
+uint32_t getUsableCpuCount()
+{
+	static const uint32_t usable = computeUsableCpuCount();
+	return usable;
+}
+
+uint32_t getCpuBudget()
+{
+	return std::max(1u, (getUsableCpuCount() + 1) / 2);
+}
@@ -0,0 +1,22 @@
+#ifndef CPU_BUDGET_H
+#define CPU_BUDGET_H
+
+#include <cstdint>
+
+/**
+  * @brief Number of CPUs this process may actually use
+  *
+  * The smallest of the online CPUs, the process affinity mask and the CPU quota of
+  * the cgroup (Linux) or job object (Windows) the process runs in.
+*/
+uint32_t getUsableCpuCount();
+
+/**
+  * @brief Threads the plugin runs its CPU work on, across all filters
+  *
+  * Half of the usable CPUs, at least one, so OBS rendering and encoding keep the
+  * rest. The shared ORT thread pools and OpenCV's pool are sized to it.
+*/
+uint32_t getCpuBudget();
+
+#endif /* CPU_BUDGET_H */
@@ -0,0 +1,198 @@
+#include "thread-placement.h"
+
+#include <obs-module.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+#include "plugin-support.h"
+#include "obs-utils/obs-config-utils.h"
+
+// Nice value of the low priority inference threads on Linux
+static const int LOW_PRIORITY_NICE = 10;
+// Highest CPU number accepted in the CPU list
+static const unsigned long MAX_CPU = 1023;
+
+std::vector<uint32_t> parseCpuList(const std::string &list)
+{
+	std::vector<uint32_t> cpus;
+	std::stringstream items(list);
+	std::string item;
+	while (std::getline(items, item, ',')) {
+		unsigned long first, last;
+		const size_t dash = item.find('-');
+		try {
+			first = std::stoul(item.substr(0, dash));
+			last = dash == std::string::npos
+				       ? first
+				       : std::stoul(item.substr(dash + 1));
+		} catch (const std::exception &) {
+			obs_log(LOG_WARNING, "Ignoring invalid CPU list item '%s'",
+				item.c_str());
+			continue;
+		}
+		if (last < first || last > MAX_CPU) {
+			obs_log(LOG_WARNING, "Ignoring invalid CPU range '%s'",
+				item.c_str());
+			continue;
+		}
+		for (unsigned long cpu = first; cpu <= last; cpu++) {
+			cpus.push_back((uint32_t)cpu);
+		}
+	}
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return cpus;
+}
+
+static ThreadPlacement readThreadPlacement()
+{
+	ThreadPlacement placement;
+	std::string cpuList;
+	getStringFromConfig("inference_cpus", cpuList, "");
+	placement.cpus = parseCpuList(cpuList);
+	getFlagFromConfig("inference_low_priority", &placement.lowPriority,
+			  false);
+	return placement;
+}
+
+const ThreadPlacement &getThreadPlacement()
+{
+	static const ThreadPlacement placement = readThreadPlacement();
+	return placement;
+}
+
+/**
+  * @brief Format a CPU list back in the "0-3,6" form
+*/
+static std::string formatCpuList(const std::vector<uint32_t> &cpus)
+{
+	std::string list;
+	for (size_t i = 0; i < cpus.size();) {
+		size_t end = i;
+		while (end + 1 < cpus.size() && cpus[end + 1] == cpus[end] + 1) {
+			end++;
+		}
+		if (!list.empty()) {
+			list += ",";
+		}
+		list += std::to_string(cpus[i]);
+		if (end > i) {
+			list += "-" + std::to_string(cpus[end]);
+		}
+		i = end + 1;
+	}
+	return list;
+}
+
+#ifdef _WIN32
+static std::vector<uint32_t> applyPlacement(const ThreadPlacement &placement)
+{
+	DWORD_PTR processMask, systemMask;
+	GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+	DWORD_PTR mask = processMask;
+	if (!placement.cpus.empty()) {
+		DWORD_PTR requested = 0;
+		for (uint32_t cpu : placement.cpus) {
+			if (cpu < sizeof(DWORD_PTR) * 8) {
+				requested |= (DWORD_PTR)1 << cpu;
+			}
+		}
+		// CPUs outside the process affinity can't be used
+		if ((requested & processMask) != 0 &&
+		    SetThreadAffinityMask(GetCurrentThread(),
+					  requested & processMask) != 0) {
+			mask = requested & processMask;
+		}
+	}
+	if (placement.lowPriority) {
+		SetThreadPriority(GetCurrentThread(),
+				  THREAD_PRIORITY_BELOW_NORMAL);
+	}
+
+	std::vector<uint32_t> effective;
+	for (uint32_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; cpu++) {
+		if (mask & ((DWORD_PTR)1 << cpu)) {
+			effective.push_back(cpu);
+		}
+	}
+	return effective;
+}
+#elif defined(__linux__)
+static std::vector<uint32_t> applyPlacement(const ThreadPlacement &placement)
+{
+	if (!placement.cpus.empty()) {
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for (uint32_t cpu : placement.cpus) {
+			if (cpu < CPU_SETSIZE) {
+				CPU_SET(cpu, &cpuSet);
+			}
+		}
+		pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+	}
+	if (placement.lowPriority) {
+		// For a thread, pid 0 and its tid address the thread itself
+		struct sched_param param = {};
+		sched_setscheduler(0, SCHED_BATCH, &param);
+		setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid),
+			    LOW_PRIORITY_NICE);
+	}
+
+	std::vector<uint32_t> effective;
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) ==
+	    0) {
+		for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &cpuSet)) {
+				effective.push_back(cpu);
+			}
+		}
+	}
+	return effective;
+}
+#else
+static std::vector<uint32_t> applyPlacement(const ThreadPlacement &placement)
+{
+	// macOS has no thread affinity, only the priority applies
+	if (placement.lowPriority) {
+		pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+	}
+	return {};
+}
+#endif
+
+void applyThreadPlacement()
+{
+	const ThreadPlacement &placement = getThreadPlacement();
+	if (placement.isDefault()) {
+		return;
+	}
+	const std::vector<uint32_t> effective = applyPlacement(placement);
+
+	static std::once_flag logged;
+	std::call_once(logged, [&] {
+		obs_log(LOG_INFO,
+			"Inference threads on CPUs %s (requested %s), %s priority",
+			effective.empty() ? "any"
+					  : formatCpuList(effective).c_str(),
+			placement.cpus.empty()
+				? "any"
+				: formatCpuList(placement.cpus).c_str(),
+			placement.lowPriority ? "low" : "normal");
+	});
+}
@@ -0,0 +1,40 @@
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+  * @brief CPUs and priority of the inference worker threads, from the plugin config
+  *
+  * inference_cpus: the CPUs to pin the threads to, e.g. "2-5,7". Empty for all.
+  * inference_low_priority: run below the OBS render and encoder threads (SCHED_BATCH
+  * and nice 10 on Linux, below normal on Windows, the utility QoS on macOS).
+*/
+struct ThreadPlacement {
+	std::vector<uint32_t> cpus;
+	bool lowPriority = false;
+
+	bool isDefault() const { return cpus.empty() && !lowPriority; }
+};
+
+/**
+  * @brief The configured placement, read once
+*/
+const ThreadPlacement &getThreadPlacement();
+
+/**
+  * @brief Parse a CPU list such as "0-3,6", invalid items are skipped
+*/
+std::vector<uint32_t> parseCpuList(const std::string &list);
+
+/**
+  * @brief Move the calling thread to the configured CPUs and priority
+  *
+  * For the threads the plugin starts: the ORT pool threads, the session builders and
+  * the depth worker. The effective placement is logged for the first thread.
+*/
+void applyThreadPlacement();
+
+#endif /* THREAD_PLACEMENT_H */
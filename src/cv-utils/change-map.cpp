@@ -0,0 +1,89 @@
+#include "change-map.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// Width of the luma thumbnail the changes are measured on
+static const int THUMBNAIL_WIDTH = 160;
+// Side of a tile, in thumbnail pixels
+static const int TILE_SIZE = 8;
+// Mean absolute luma difference of a changed tile, above the sensor noise left
+// after the downscale
+static const double TILE_CHANGE_THRESHOLD = 4.0;
+// Mask tiles with a mean between these are on its edge
+static const double EDGE_LOW = 0.03 * 255.0;
+static const double EDGE_HIGH = 0.97 * 255.0;
+// Tiles around the edge in which changes still matter
+static const int EDGE_MARGIN_TILES = 1;
+// Beyond this share of changed tiles, e.g. when the camera moves, the whole frame
+// is inferred
+static const double MAX_CHANGED_SHARE = 0.3;
+// Decisions between inferences, so changes the edge test misses don't keep an old
+// mask
+static const int FULL_REFRESH_DECISIONS = 30;
+
+void resetChangeMap(ChangeMap &map)
+{
+	map.reference.release();
+	map.decisionsSinceFull = 0;
+}
+
+void commitChangeMap(ChangeMap &map)
+{
+	map.thumbnail.copyTo(map.reference);
+	map.decisionsSinceFull = 0;
+}
+
+ChangeDecision updateChangeMap(ChangeMap &map, const cv::Mat &image,
+			       const cv::Mat &mask)
+{
+	// A thumbnail of whole tiles, its aspect ratio kept to within a tile
+	const int thumbnailHeight = std::max(
+		TILE_SIZE,
+		(int)std::lround((double)THUMBNAIL_WIDTH * image.rows /
+				 image.cols / TILE_SIZE) *
+			TILE_SIZE);
+	const cv::Size thumbnailSize(THUMBNAIL_WIDTH, thumbnailHeight);
+	const cv::Size gridSize(THUMBNAIL_WIDTH / TILE_SIZE,
+				thumbnailHeight / TILE_SIZE);
+	if (image.channels() == 1) {
+		cv::resize(image, map.thumbnail, thumbnailSize, 0, 0,
+			   cv::INTER_AREA);
+	} else {
+		cv::resize(image, map.thumbnailBGRA, thumbnailSize, 0, 0,
+			   cv::INTER_AREA);
+		cv::cvtColor(map.thumbnailBGRA, map.thumbnail,
+			     cv::COLOR_BGRA2GRAY);
+	}
+
+	if (map.reference.size() != map.thumbnail.size()) {
+		// First frame, or the source size changed
+		map.changed = cv::Mat(gridSize, CV_8UC1, cv::Scalar(255));
+		return CHANGE_DECISION_FULL;
+	}
+
+	cv::absdiff(map.thumbnail, map.reference, map.difference);
+	// The area resize is the mean of each tile
+	cv::resize(map.difference, map.scores, gridSize, 0, 0,
+		   cv::INTER_AREA);
+	cv::compare(map.scores, TILE_CHANGE_THRESHOLD, map.changed,
+		    cv::CMP_GT);
+
+	if (mask.empty() ||
+	    ++map.decisionsSinceFull >= FULL_REFRESH_DECISIONS ||
+	    cv::countNonZero(map.changed) >
+		    MAX_CHANGED_SHARE * (double)map.changed.total()) {
+		return CHANGE_DECISION_FULL;
+	}
+
+	// The changed tiles near the mask edge
+	cv::resize(mask, map.edge, gridSize, 0, 0, cv::INTER_AREA);
+	cv::inRange(map.edge, EDGE_LOW, EDGE_HIGH, map.edge);
+	cv::dilate(map.edge, map.edge, cv::Mat(), cv::Point(-1, -1),
+		   EDGE_MARGIN_TILES);
+	cv::bitwise_and(map.edge, map.changed, map.edge);
+	return cv::countNonZero(map.edge) == 0 ? CHANGE_DECISION_SKIP
+					       : CHANGE_DECISION_FULL;
+}
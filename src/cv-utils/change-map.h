@@ -0,0 +1,60 @@
+#ifndef CHANGE_MAP_H
+#define CHANGE_MAP_H
+
+#include <opencv2/core.hpp>
+
+/**
+  * @brief Where a frame needs a new inference
+*/
+enum ChangeDecision {
+	// The whole frame
+	CHANGE_DECISION_FULL = 0,
+	// Nothing changed near the mask edge, the mask stays
+	CHANGE_DECISION_SKIP,
+};
+
+/**
+  * @brief Tile grid of the changes of a frame since the frame the mask was last
+  * inferred on, from a low resolution luma thumbnail
+*/
+struct ChangeMap {
+	// Luma thumbnails of the current frame and of the inferred frame
+	cv::Mat thumbnail;
+	cv::Mat reference;
+	cv::Mat thumbnailBGRA;
+	cv::Mat difference;
+	// Mean absolute luma difference of each tile, CV_8UC1
+	cv::Mat scores;
+	// 255 where a tile changed, CV_8UC1
+	cv::Mat changed;
+	// 255 near the mask edge, CV_8UC1
+	cv::Mat edge;
+	// Decisions since the last full inference
+	int decisionsSinceFull = 0;
+};
+
+/**
+  * @brief Update the change map with a frame and decide whether to infer
+  *
+  * Changes only matter near the edge of the current mask: the rest of the frame is
+  * static background, or the inside of the person. Frames with no such change are
+  * skipped. Any other change, and a periodic refresh, infer the whole frame. The
+  * reference thumbnail is left as is until commitChangeMap.
+  *
+  * @param image The frame, CV_8UC1 luma or CV_8UC4 BGRA
+  * @param mask The current mask at any resolution, empty to force a full inference
+*/
+ChangeDecision updateChangeMap(ChangeMap &map, const cv::Mat &image,
+			       const cv::Mat &mask);
+
+/**
+  * @brief Make the last updated frame the reference, once its inference succeeded
+*/
+void commitChangeMap(ChangeMap &map);
+
+/**
+  * @brief Drop the reference, the next update infers the whole frame
+*/
+void resetChangeMap(ChangeMap &map);
+
+#endif /* CHANGE_MAP_H */
@@ -0,0 +1,57 @@
+#ifndef LAYOUT_KERNELS_IMPL_H
+#define LAYOUT_KERNELS_IMPL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kernels handle 2-4 channels. They convert whole SIMD blocks and leave the
+// remaining pixels to the scalar kernels below.
+typedef void (*LayoutKernelF32)(const float *src, float *dst, size_t pixels,
+				int channels);
+typedef void (*LayoutKernelU8)(const uint8_t *src, uint8_t *dst,
+			       size_t pixels, int channels);
+
+struct LayoutKernelVariant {
+	const char *name;
+	LayoutKernelF32 deinterleaveF32;
+	LayoutKernelF32 interleaveF32;
+	LayoutKernelU8 deinterleaveU8;
+	LayoutKernelU8 interleaveU8;
+};
+
+/**
+  * @brief Append the x86 variants this CPU supports, slowest first
+*/
+void appendX86LayoutKernels(std::vector<LayoutKernelVariant> &variants);
+
+/**
+  * @brief Append the NEON variant if this CPU supports it
+*/
+void appendNeonLayoutKernels(std::vector<LayoutKernelVariant> &variants);
+
+template<typename T>
+static inline void deinterleaveScalar(const T *src, T *dst, size_t pixels,
+				      int channels, size_t first = 0)
+{
+	for (int c = 0; c < channels; c++) {
+		T *plane = dst + c * pixels;
+		for (size_t i = first; i < pixels; i++) {
+			plane[i] = src[i * channels + c];
+		}
+	}
+}
+
+template<typename T>
+static inline void interleaveScalar(const T *src, T *dst, size_t pixels,
+				    int channels, size_t first = 0)
+{
+	for (int c = 0; c < channels; c++) {
+		const T *plane = src + c * pixels;
+		for (size_t i = first; i < pixels; i++) {
+			dst[i * channels + c] = plane[i];
+		}
+	}
+}
+
+#endif /* LAYOUT_KERNELS_IMPL_H */
@@ -0,0 +1,157 @@
+#include "layout-kernels-impl.h"
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+
+#include <opencv2/core.hpp>
+
+#include <arm_neon.h>
+
+// NEON has structured loads and stores for 2-4 interleaved channels
+
+static void deinterleaveF32Neon(const float *src, float *dst, size_t pixels,
+				int channels)
+{
+	float *d0 = dst, *d1 = dst + pixels, *d2 = dst + 2 * pixels,
+	      *d3 = dst + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= pixels; i += 4) {
+			const float32x4x2_t v = vld2q_f32(src + 2 * i);
+			vst1q_f32(d0 + i, v.val[0]);
+			vst1q_f32(d1 + i, v.val[1]);
+		}
+	} else if (channels == 3) {
+		for (; i + 4 <= pixels; i += 4) {
+			const float32x4x3_t v = vld3q_f32(src + 3 * i);
+			vst1q_f32(d0 + i, v.val[0]);
+			vst1q_f32(d1 + i, v.val[1]);
+			vst1q_f32(d2 + i, v.val[2]);
+		}
+	} else if (channels == 4) {
+		for (; i + 4 <= pixels; i += 4) {
+			const float32x4x4_t v = vld4q_f32(src + 4 * i);
+			vst1q_f32(d0 + i, v.val[0]);
+			vst1q_f32(d1 + i, v.val[1]);
+			vst1q_f32(d2 + i, v.val[2]);
+			vst1q_f32(d3 + i, v.val[3]);
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+static void interleaveF32Neon(const float *src, float *dst, size_t pixels,
+			      int channels)
+{
+	const float *s0 = src, *s1 = src + pixels, *s2 = src + 2 * pixels,
+		    *s3 = src + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= pixels; i += 4) {
+			float32x4x2_t v;
+			v.val[0] = vld1q_f32(s0 + i);
+			v.val[1] = vld1q_f32(s1 + i);
+			vst2q_f32(dst + 2 * i, v);
+		}
+	} else if (channels == 3) {
+		for (; i + 4 <= pixels; i += 4) {
+			float32x4x3_t v;
+			v.val[0] = vld1q_f32(s0 + i);
+			v.val[1] = vld1q_f32(s1 + i);
+			v.val[2] = vld1q_f32(s2 + i);
+			vst3q_f32(dst + 3 * i, v);
+		}
+	} else if (channels == 4) {
+		for (; i + 4 <= pixels; i += 4) {
+			float32x4x4_t v;
+			v.val[0] = vld1q_f32(s0 + i);
+			v.val[1] = vld1q_f32(s1 + i);
+			v.val[2] = vld1q_f32(s2 + i);
+			v.val[3] = vld1q_f32(s3 + i);
+			vst4q_f32(dst + 4 * i, v);
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+static void deinterleaveU8Neon(const uint8_t *src, uint8_t *dst, size_t pixels,
+			       int channels)
+{
+	uint8_t *d0 = dst, *d1 = dst + pixels, *d2 = dst + 2 * pixels,
+		*d3 = dst + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 16 <= pixels; i += 16) {
+			const uint8x16x2_t v = vld2q_u8(src + 2 * i);
+			vst1q_u8(d0 + i, v.val[0]);
+			vst1q_u8(d1 + i, v.val[1]);
+		}
+	} else if (channels == 3) {
+		for (; i + 16 <= pixels; i += 16) {
+			const uint8x16x3_t v = vld3q_u8(src + 3 * i);
+			vst1q_u8(d0 + i, v.val[0]);
+			vst1q_u8(d1 + i, v.val[1]);
+			vst1q_u8(d2 + i, v.val[2]);
+		}
+	} else if (channels == 4) {
+		for (; i + 16 <= pixels; i += 16) {
+			const uint8x16x4_t v = vld4q_u8(src + 4 * i);
+			vst1q_u8(d0 + i, v.val[0]);
+			vst1q_u8(d1 + i, v.val[1]);
+			vst1q_u8(d2 + i, v.val[2]);
+			vst1q_u8(d3 + i, v.val[3]);
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+static void interleaveU8Neon(const uint8_t *src, uint8_t *dst, size_t pixels,
+			     int channels)
+{
+	const uint8_t *s0 = src, *s1 = src + pixels, *s2 = src + 2 * pixels,
+		      *s3 = src + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 16 <= pixels; i += 16) {
+			uint8x16x2_t v;
+			v.val[0] = vld1q_u8(s0 + i);
+			v.val[1] = vld1q_u8(s1 + i);
+			vst2q_u8(dst + 2 * i, v);
+		}
+	} else if (channels == 3) {
+		for (; i + 16 <= pixels; i += 16) {
+			uint8x16x3_t v;
+			v.val[0] = vld1q_u8(s0 + i);
+			v.val[1] = vld1q_u8(s1 + i);
+			v.val[2] = vld1q_u8(s2 + i);
+			vst3q_u8(dst + 3 * i, v);
+		}
+	} else if (channels == 4) {
+		for (; i + 16 <= pixels; i += 16) {
+			uint8x16x4_t v;
+			v.val[0] = vld1q_u8(s0 + i);
+			v.val[1] = vld1q_u8(s1 + i);
+			v.val[2] = vld1q_u8(s2 + i);
+			v.val[3] = vld1q_u8(s3 + i);
+			vst4q_u8(dst + 4 * i, v);
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+void appendNeonLayoutKernels(std::vector<LayoutKernelVariant> &variants)
+{
+	if (!cv::checkHardwareSupport(CV_CPU_NEON)) {
+		return;
+	}
+	variants.push_back({"NEON", deinterleaveF32Neon, interleaveF32Neon,
+			    deinterleaveU8Neon, interleaveU8Neon});
+}
+
+#else
+
+void appendNeonLayoutKernels(std::vector<LayoutKernelVariant> &variants)
+{
+	(void)variants;
+}
+
+#endif
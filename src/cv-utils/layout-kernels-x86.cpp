@@ -0,0 +1,564 @@
+#include "layout-kernels-impl.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+	defined(_M_IX86)
+
+#include <opencv2/core.hpp>
+
+#include <immintrin.h>
+
+// Each kernel is compiled for its own instruction set, independently of the
+// compiler flags of the plugin, and only called if the CPU supports it.
+// MSVC accepts any intrinsic without flags.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define LAYOUT_TARGET(isa)
+#else
+#define LAYOUT_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/**                   SSE4.1                     */
+
+LAYOUT_TARGET("sse4.1")
+static void deinterleaveF32Sse41(const float *src, float *dst, size_t pixels,
+				 int channels)
+{
+	float *d0 = dst, *d1 = dst + pixels, *d2 = dst + 2 * pixels,
+	      *d3 = dst + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= pixels; i += 4) {
+			const __m128 v0 = _mm_loadu_ps(src + 2 * i);
+			const __m128 v1 = _mm_loadu_ps(src + 2 * i + 4);
+			_mm_storeu_ps(d0 + i, _mm_shuffle_ps(v0, v1,
+							     _MM_SHUFFLE(2, 0,
+									 2, 0)));
+			_mm_storeu_ps(d1 + i, _mm_shuffle_ps(v0, v1,
+							     _MM_SHUFFLE(3, 1,
+									 3, 1)));
+		}
+	} else if (channels == 3) {
+		for (; i + 4 <= pixels; i += 4) {
+			// r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+			const __m128 v0 = _mm_loadu_ps(src + 3 * i);
+			const __m128 v1 = _mm_loadu_ps(src + 3 * i + 4);
+			const __m128 v2 = _mm_loadu_ps(src + 3 * i + 8);
+			// r0 r3 r2 r1, g1 g0 g3 g2, b2 b1 b0 b3
+			const __m128 r = _mm_blend_ps(_mm_blend_ps(v0, v1, 0x4),
+						      v2, 0x2);
+			const __m128 g = _mm_blend_ps(_mm_blend_ps(v0, v1, 0x9),
+						      v2, 0x4);
+			const __m128 b = _mm_blend_ps(_mm_blend_ps(v0, v1, 0x2),
+						      v2, 0x9);
+			_mm_storeu_ps(d0 + i,
+				      _mm_shuffle_ps(r, r,
+						     _MM_SHUFFLE(1, 2, 3, 0)));
+			_mm_storeu_ps(d1 + i,
+				      _mm_shuffle_ps(g, g,
+						     _MM_SHUFFLE(2, 3, 0, 1)));
+			_mm_storeu_ps(d2 + i,
+				      _mm_shuffle_ps(b, b,
+						     _MM_SHUFFLE(3, 0, 1, 2)));
+		}
+	} else if (channels == 4) {
+		for (; i + 4 <= pixels; i += 4) {
+			__m128 v0 = _mm_loadu_ps(src + 4 * i);
+			__m128 v1 = _mm_loadu_ps(src + 4 * i + 4);
+			__m128 v2 = _mm_loadu_ps(src + 4 * i + 8);
+			__m128 v3 = _mm_loadu_ps(src + 4 * i + 12);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps(d0 + i, v0);
+			_mm_storeu_ps(d1 + i, v1);
+			_mm_storeu_ps(d2 + i, v2);
+			_mm_storeu_ps(d3 + i, v3);
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("sse4.1")
+static void interleaveF32Sse41(const float *src, float *dst, size_t pixels,
+			       int channels)
+{
+	const float *s0 = src, *s1 = src + pixels, *s2 = src + 2 * pixels,
+		    *s3 = src + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 4 <= pixels; i += 4) {
+			const __m128 a = _mm_loadu_ps(s0 + i);
+			const __m128 b = _mm_loadu_ps(s1 + i);
+			_mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(a, b));
+			_mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(a, b));
+		}
+	} else if (channels == 3) {
+		for (; i + 4 <= pixels; i += 4) {
+			// The inverse of the deinterleave permutations
+			__m128 r = _mm_loadu_ps(s0 + i);
+			__m128 g = _mm_loadu_ps(s1 + i);
+			__m128 b = _mm_loadu_ps(s2 + i);
+			r = _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 2, 3, 0));
+			g = _mm_shuffle_ps(g, g, _MM_SHUFFLE(2, 3, 0, 1));
+			b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 1, 2));
+			_mm_storeu_ps(dst + 3 * i,
+				      _mm_blend_ps(_mm_blend_ps(r, g, 0x2), b,
+						   0x4));
+			_mm_storeu_ps(dst + 3 * i + 4,
+				      _mm_blend_ps(_mm_blend_ps(g, b, 0x2), r,
+						   0x4));
+			_mm_storeu_ps(dst + 3 * i + 8,
+				      _mm_blend_ps(_mm_blend_ps(b, r, 0x2), g,
+						   0x4));
+		}
+	} else if (channels == 4) {
+		for (; i + 4 <= pixels; i += 4) {
+			__m128 v0 = _mm_loadu_ps(s0 + i);
+			__m128 v1 = _mm_loadu_ps(s1 + i);
+			__m128 v2 = _mm_loadu_ps(s2 + i);
+			__m128 v3 = _mm_loadu_ps(s3 + i);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps(dst + 4 * i, v0);
+			_mm_storeu_ps(dst + 4 * i + 4, v1);
+			_mm_storeu_ps(dst + 4 * i + 8, v2);
+			_mm_storeu_ps(dst + 4 * i + 12, v3);
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+// Byte shuffles: every output vector is the OR of one pshufb per input vector,
+// with 0x80 zeroing the bytes that come from another input vector.
+
+LAYOUT_TARGET("sse4.1")
+static void deinterleaveU8Sse41(const uint8_t *src, uint8_t *dst,
+				size_t pixels, int channels)
+{
+	__m128i masks[4][4];
+	for (int c = 0; c < channels; c++) {
+		for (int v = 0; v < channels; v++) {
+			alignas(16) uint8_t mask[16];
+			for (int j = 0; j < 16; j++) {
+				const int e = channels * j + c;
+				mask[j] = e / 16 == v ? (uint8_t)(e % 16)
+						      : 0x80;
+			}
+			masks[c][v] = _mm_load_si128((const __m128i *)mask);
+		}
+	}
+
+	size_t i = 0;
+	for (; i + 16 <= pixels; i += 16) {
+		__m128i in[4];
+		for (int v = 0; v < channels; v++) {
+			in[v] = _mm_loadu_si128(
+				(const __m128i *)(src + channels * i + 16 * v));
+		}
+		for (int c = 0; c < channels; c++) {
+			__m128i out = _mm_shuffle_epi8(in[0], masks[c][0]);
+			for (int v = 1; v < channels; v++) {
+				out = _mm_or_si128(
+					out, _mm_shuffle_epi8(in[v], masks[c][v]));
+			}
+			_mm_storeu_si128((__m128i *)(dst + c * pixels + i),
+					 out);
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("sse4.1")
+static void interleaveU8Sse41(const uint8_t *src, uint8_t *dst, size_t pixels,
+			      int channels)
+{
+	__m128i masks[4][4];
+	for (int k = 0; k < channels; k++) {
+		for (int c = 0; c < channels; c++) {
+			alignas(16) uint8_t mask[16];
+			for (int j = 0; j < 16; j++) {
+				const int e = 16 * k + j;
+				mask[j] = e % channels == c
+						  ? (uint8_t)(e / channels)
+						  : 0x80;
+			}
+			masks[k][c] = _mm_load_si128((const __m128i *)mask);
+		}
+	}
+
+	size_t i = 0;
+	for (; i + 16 <= pixels; i += 16) {
+		__m128i in[4];
+		for (int c = 0; c < channels; c++) {
+			in[c] = _mm_loadu_si128(
+				(const __m128i *)(src + c * pixels + i));
+		}
+		for (int k = 0; k < channels; k++) {
+			__m128i out = _mm_shuffle_epi8(in[0], masks[k][0]);
+			for (int c = 1; c < channels; c++) {
+				out = _mm_or_si128(
+					out, _mm_shuffle_epi8(in[c], masks[k][c]));
+			}
+			_mm_storeu_si128(
+				(__m128i *)(dst + channels * i + 16 * k), out);
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+/**                   AVX2                     */
+
+// AVX shuffles don't cross 128-bit lanes, so the kernels first arrange the data
+// to hold 4 pixels per lane, then run the SSE shuffles on both lanes at once.
+
+LAYOUT_TARGET("avx2")
+static inline void transpose4x4Lanes(__m256 &a, __m256 &b, __m256 &c,
+				     __m256 &d)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(a, b);
+	const __m256 t1 = _mm256_unpacklo_ps(c, d);
+	const __m256 t2 = _mm256_unpackhi_ps(a, b);
+	const __m256 t3 = _mm256_unpackhi_ps(c, d);
+	a = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	b = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	c = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	d = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+LAYOUT_TARGET("avx2")
+static void deinterleaveF32Avx2(const float *src, float *dst, size_t pixels,
+				int channels)
+{
+	float *d0 = dst, *d1 = dst + pixels, *d2 = dst + 2 * pixels,
+	      *d3 = dst + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 8 <= pixels; i += 8) {
+			const __m256 v0 = _mm256_loadu_ps(src + 2 * i);
+			const __m256 v1 = _mm256_loadu_ps(src + 2 * i + 8);
+			// a0 a1 a4 a5 | a2 a3 a6 a7, then put the pairs in order
+			const __m256 a = _mm256_shuffle_ps(v0, v1,
+							   _MM_SHUFFLE(2, 0, 2,
+								       0));
+			const __m256 b = _mm256_shuffle_ps(v0, v1,
+							   _MM_SHUFFLE(3, 1, 3,
+								       1));
+			_mm256_storeu_ps(d0 + i,
+					 _mm256_castpd_ps(_mm256_permute4x64_pd(
+						 _mm256_castps_pd(a),
+						 _MM_SHUFFLE(3, 1, 2, 0))));
+			_mm256_storeu_ps(d1 + i,
+					 _mm256_castpd_ps(_mm256_permute4x64_pd(
+						 _mm256_castps_pd(b),
+						 _MM_SHUFFLE(3, 1, 2, 0))));
+		}
+	} else if (channels == 3) {
+		for (; i + 8 <= pixels; i += 8) {
+			const __m256 y0 = _mm256_loadu_ps(src + 3 * i);
+			const __m256 y1 = _mm256_loadu_ps(src + 3 * i + 8);
+			const __m256 y2 = _mm256_loadu_ps(src + 3 * i + 16);
+			// Pixels 0-3 in the low lanes, 4-7 in the high lanes
+			const __m256 v0 = _mm256_permute2f128_ps(y0, y1, 0x30);
+			const __m256 v1 = _mm256_permute2f128_ps(y0, y2, 0x21);
+			const __m256 v2 = _mm256_permute2f128_ps(y1, y2, 0x30);
+			const __m256 r = _mm256_blend_ps(
+				_mm256_blend_ps(v0, v1, 0x44), v2, 0x22);
+			const __m256 g = _mm256_blend_ps(
+				_mm256_blend_ps(v0, v1, 0x99), v2, 0x44);
+			const __m256 b = _mm256_blend_ps(
+				_mm256_blend_ps(v0, v1, 0x22), v2, 0x99);
+			_mm256_storeu_ps(d0 + i, _mm256_shuffle_ps(
+							 r, r,
+							 _MM_SHUFFLE(1, 2, 3,
+								     0)));
+			_mm256_storeu_ps(d1 + i, _mm256_shuffle_ps(
+							 g, g,
+							 _MM_SHUFFLE(2, 3, 0,
+								     1)));
+			_mm256_storeu_ps(d2 + i, _mm256_shuffle_ps(
+							 b, b,
+							 _MM_SHUFFLE(3, 0, 1,
+								     2)));
+		}
+	} else if (channels == 4) {
+		for (; i + 8 <= pixels; i += 8) {
+			const __m256 y0 = _mm256_loadu_ps(src + 4 * i);
+			const __m256 y1 = _mm256_loadu_ps(src + 4 * i + 8);
+			const __m256 y2 = _mm256_loadu_ps(src + 4 * i + 16);
+			const __m256 y3 = _mm256_loadu_ps(src + 4 * i + 24);
+			// Pixels 0-3 in the low lanes, 4-7 in the high lanes
+			__m256 a = _mm256_permute2f128_ps(y0, y2, 0x20);
+			__m256 b = _mm256_permute2f128_ps(y0, y2, 0x31);
+			__m256 c = _mm256_permute2f128_ps(y1, y3, 0x20);
+			__m256 d = _mm256_permute2f128_ps(y1, y3, 0x31);
+			transpose4x4Lanes(a, b, c, d);
+			_mm256_storeu_ps(d0 + i, a);
+			_mm256_storeu_ps(d1 + i, b);
+			_mm256_storeu_ps(d2 + i, c);
+			_mm256_storeu_ps(d3 + i, d);
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("avx2")
+static void interleaveF32Avx2(const float *src, float *dst, size_t pixels,
+			      int channels)
+{
+	const float *s0 = src, *s1 = src + pixels, *s2 = src + 2 * pixels,
+		    *s3 = src + 3 * pixels;
+	size_t i = 0;
+	if (channels == 2) {
+		for (; i + 8 <= pixels; i += 8) {
+			const __m256 a = _mm256_loadu_ps(s0 + i);
+			const __m256 b = _mm256_loadu_ps(s1 + i);
+			const __m256 lo = _mm256_unpacklo_ps(a, b);
+			const __m256 hi = _mm256_unpackhi_ps(a, b);
+			_mm256_storeu_ps(dst + 2 * i,
+					 _mm256_permute2f128_ps(lo, hi, 0x20));
+			_mm256_storeu_ps(dst + 2 * i + 8,
+					 _mm256_permute2f128_ps(lo, hi, 0x31));
+		}
+	} else if (channels == 3) {
+		for (; i + 8 <= pixels; i += 8) {
+			__m256 r = _mm256_loadu_ps(s0 + i);
+			__m256 g = _mm256_loadu_ps(s1 + i);
+			__m256 b = _mm256_loadu_ps(s2 + i);
+			r = _mm256_shuffle_ps(r, r, _MM_SHUFFLE(1, 2, 3, 0));
+			g = _mm256_shuffle_ps(g, g, _MM_SHUFFLE(2, 3, 0, 1));
+			b = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 1, 2));
+			const __m256 v0 = _mm256_blend_ps(
+				_mm256_blend_ps(r, g, 0x22), b, 0x44);
+			const __m256 v1 = _mm256_blend_ps(
+				_mm256_blend_ps(g, b, 0x22), r, 0x44);
+			const __m256 v2 = _mm256_blend_ps(
+				_mm256_blend_ps(b, r, 0x22), g, 0x44);
+			_mm256_storeu_ps(dst + 3 * i,
+					 _mm256_permute2f128_ps(v0, v1, 0x20));
+			_mm256_storeu_ps(dst + 3 * i + 8,
+					 _mm256_permute2f128_ps(v2, v0, 0x30));
+			_mm256_storeu_ps(dst + 3 * i + 16,
+					 _mm256_permute2f128_ps(v1, v2, 0x31));
+		}
+	} else if (channels == 4) {
+		for (; i + 8 <= pixels; i += 8) {
+			__m256 a = _mm256_loadu_ps(s0 + i);
+			__m256 b = _mm256_loadu_ps(s1 + i);
+			__m256 c = _mm256_loadu_ps(s2 + i);
+			__m256 d = _mm256_loadu_ps(s3 + i);
+			transpose4x4Lanes(a, b, c, d);
+			_mm256_storeu_ps(dst + 4 * i,
+					 _mm256_permute2f128_ps(a, b, 0x20));
+			_mm256_storeu_ps(dst + 4 * i + 8,
+					 _mm256_permute2f128_ps(c, d, 0x20));
+			_mm256_storeu_ps(dst + 4 * i + 16,
+					 _mm256_permute2f128_ps(a, b, 0x31));
+			_mm256_storeu_ps(dst + 4 * i + 24,
+					 _mm256_permute2f128_ps(c, d, 0x31));
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+/**                   AVX-512                     */
+
+// Two-table permutes reach any of 32 floats (64 bytes with VBMI), so one
+// generic kernel covers all channel counts: each output vector is gathered from
+// the first two input vectors and from the last two, and the halves blended.
+
+LAYOUT_TARGET("avx512f")
+static void deinterleaveF32Avx512(const float *src, float *dst, size_t pixels,
+				  int channels)
+{
+	__m512i indices[4];
+	__mmask16 highMasks[4];
+	for (int c = 0; c < channels; c++) {
+		alignas(64) int32_t index[16];
+		int highMask = 0;
+		for (int j = 0; j < 16; j++) {
+			const int e = channels * j + c;
+			index[j] = e & 31;
+			highMask |= (e >= 32) << j;
+		}
+		indices[c] = _mm512_load_si512(index);
+		highMasks[c] = (__mmask16)highMask;
+	}
+
+	size_t i = 0;
+	for (; i + 16 <= pixels; i += 16) {
+		__m512 in[4];
+		for (int v = 0; v < 4; v++) {
+			// Vectors past the channel count are never selected
+			in[v] = _mm512_loadu_ps(
+				src + channels * i +
+				16 * (v < channels ? v : channels - 1));
+		}
+		for (int c = 0; c < channels; c++) {
+			const __m512 lo = _mm512_permutex2var_ps(
+				in[0], indices[c], in[1]);
+			const __m512 hi = _mm512_permutex2var_ps(
+				in[2], indices[c], in[3]);
+			_mm512_storeu_ps(dst + c * pixels + i,
+					 _mm512_mask_blend_ps(highMasks[c], lo,
+							      hi));
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("avx512f")
+static void interleaveF32Avx512(const float *src, float *dst, size_t pixels,
+				int channels)
+{
+	__m512i indices[4];
+	__mmask16 highMasks[4];
+	for (int k = 0; k < channels; k++) {
+		alignas(64) int32_t index[16];
+		int highMask = 0;
+		for (int j = 0; j < 16; j++) {
+			const int e = 16 * k + j;
+			const int c = e % channels;
+			index[j] = (c & 1) * 16 + e / channels;
+			highMask |= (c >= 2) << j;
+		}
+		indices[k] = _mm512_load_si512(index);
+		highMasks[k] = (__mmask16)highMask;
+	}
+
+	size_t i = 0;
+	for (; i + 16 <= pixels; i += 16) {
+		__m512 in[4];
+		for (int c = 0; c < 4; c++) {
+			in[c] = _mm512_loadu_ps(
+				src + (c < channels ? c : channels - 1) *
+					      pixels +
+				i);
+		}
+		for (int k = 0; k < channels; k++) {
+			const __m512 lo = _mm512_permutex2var_ps(
+				in[0], indices[k], in[1]);
+			const __m512 hi = _mm512_permutex2var_ps(
+				in[2], indices[k], in[3]);
+			_mm512_storeu_ps(dst + channels * i + 16 * k,
+					 _mm512_mask_blend_ps(highMasks[k], lo,
+							      hi));
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("avx512f,avx512bw,avx512vbmi")
+static void deinterleaveU8Avx512Vbmi(const uint8_t *src, uint8_t *dst,
+				     size_t pixels, int channels)
+{
+	__m512i indices[4];
+	__mmask64 highMasks[4];
+	for (int c = 0; c < channels; c++) {
+		alignas(64) uint8_t index[64];
+		uint64_t highMask = 0;
+		for (int j = 0; j < 64; j++) {
+			const int e = channels * j + c;
+			index[j] = (uint8_t)(e & 127);
+			highMask |= (uint64_t)(e >= 128) << j;
+		}
+		indices[c] = _mm512_load_si512(index);
+		highMasks[c] = (__mmask64)highMask;
+	}
+
+	size_t i = 0;
+	for (; i + 64 <= pixels; i += 64) {
+		__m512i in[4];
+		for (int v = 0; v < 4; v++) {
+			in[v] = _mm512_loadu_si512(
+				src + channels * i +
+				64 * (v < channels ? v : channels - 1));
+		}
+		for (int c = 0; c < channels; c++) {
+			const __m512i lo = _mm512_permutex2var_epi8(
+				in[0], indices[c], in[1]);
+			const __m512i hi = _mm512_permutex2var_epi8(
+				in[2], indices[c], in[3]);
+			_mm512_storeu_si512(dst + c * pixels + i,
+					    _mm512_mask_blend_epi8(highMasks[c],
+								   lo, hi));
+		}
+	}
+	deinterleaveScalar(src, dst, pixels, channels, i);
+}
+
+LAYOUT_TARGET("avx512f,avx512bw,avx512vbmi")
+static void interleaveU8Avx512Vbmi(const uint8_t *src, uint8_t *dst,
+				   size_t pixels, int channels)
+{
+	__m512i indices[4];
+	__mmask64 highMasks[4];
+	for (int k = 0; k < channels; k++) {
+		alignas(64) uint8_t index[64];
+		uint64_t highMask = 0;
+		for (int j = 0; j < 64; j++) {
+			const int e = 64 * k + j;
+			const int c = e % channels;
+			index[j] = (uint8_t)((c & 1) * 64 + e / channels);
+			highMask |= (uint64_t)(c >= 2) << j;
+		}
+		indices[k] = _mm512_load_si512(index);
+		highMasks[k] = (__mmask64)highMask;
+	}
+
+	size_t i = 0;
+	for (; i + 64 <= pixels; i += 64) {
+		__m512i in[4];
+		for (int c = 0; c < 4; c++) {
+			in[c] = _mm512_loadu_si512(
+				src + (c < channels ? c : channels - 1) *
+					      pixels +
+				i);
+		}
+		for (int k = 0; k < channels; k++) {
+			const __m512i lo = _mm512_permutex2var_epi8(
+				in[0], indices[k], in[1]);
+			const __m512i hi = _mm512_permutex2var_epi8(
+				in[2], indices[k], in[3]);
+			_mm512_storeu_si512(dst + channels * i + 64 * k,
+					    _mm512_mask_blend_epi8(highMasks[k],
+								   lo, hi));
+		}
+	}
+	interleaveScalar(src, dst, pixels, channels, i);
+}
+
+void appendX86LayoutKernels(std::vector<LayoutKernelVariant> &variants)
+{
+	if (!cv::checkHardwareSupport(CV_CPU_SSE4_1)) {
+		return;
+	}
+	variants.push_back({"SSE4.1", deinterleaveF32Sse41, interleaveF32Sse41,
+			    deinterleaveU8Sse41, interleaveU8Sse41});
+
+	// The byte shuffles don't cross lanes either, AVX2 keeps the SSE4.1 uint8 kernels
+	if (cv::checkHardwareSupport(CV_CPU_AVX2)) {
+		variants.push_back({"AVX2", deinterleaveF32Avx2,
+				    interleaveF32Avx2, deinterleaveU8Sse41,
+				    interleaveU8Sse41});
+	}
+
+	if (cv::checkHardwareSupport(CV_CPU_AVX_512F)) {
+		if (cv::checkHardwareSupport(CV_CPU_AVX_512BW) &&
+		    cv::checkHardwareSupport(CV_CPU_AVX_512VBMI)) {
+			variants.push_back({"AVX-512", deinterleaveF32Avx512,
+					    interleaveF32Avx512,
+					    deinterleaveU8Avx512Vbmi,
+					    interleaveU8Avx512Vbmi});
+		} else {
+			variants.push_back({"AVX-512F", deinterleaveF32Avx512,
+					    interleaveF32Avx512,
+					    deinterleaveU8Sse41,
+					    interleaveU8Sse41});
+		}
+	}
+}
+
+#else
+
+void appendX86LayoutKernels(std::vector<LayoutKernelVariant> &variants)
+{
+	(void)variants;
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "layout-kernels.h"
+#include "layout-kernels-impl.h"
+
+#include <obs-module.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "plugin-support.h"
+
+static void deinterleaveF32Scalar(const float *src, float *dst, size_t pixels,
+				  int channels)
+{
+	deinterleaveScalar(src, dst, pixels, channels);
+}
+
+static void interleaveF32Scalar(const float *src, float *dst, size_t pixels,
+				int channels)
+{
+	interleaveScalar(src, dst, pixels, channels);
+}
+
+static void deinterleaveU8Scalar(const uint8_t *src, uint8_t *dst,
+				 size_t pixels, int channels)
+{
+	deinterleaveScalar(src, dst, pixels, channels);
+}
+
+static void interleaveU8Scalar(const uint8_t *src, uint8_t *dst, size_t pixels,
+			       int channels)
+{
+	interleaveScalar(src, dst, pixels, channels);
+}
+
+/**
+  * @brief All the variants this CPU can run, the scalar kernels first and the
+  * fastest last
+*/
+static const std::vector<LayoutKernelVariant> &getLayoutKernelVariants()
+{
+	static const std::vector<LayoutKernelVariant> variants = [] {
+		std::vector<LayoutKernelVariant> v;
+		v.push_back({"scalar", deinterleaveF32Scalar,
+			     interleaveF32Scalar, deinterleaveU8Scalar,
+			     interleaveU8Scalar});
+		appendX86LayoutKernels(v);
+		appendNeonLayoutKernels(v);
+		return v;
+	}();
+	return variants;
+}
+
+static const LayoutKernelVariant &selectLayoutKernels()
+{
+	const LayoutKernelVariant &selected = getLayoutKernelVariants().back();
+	obs_log(LOG_INFO, "Using %s layout conversion kernels", selected.name);
+#ifdef _DEBUG
+	benchmarkLayoutKernels();
+#endif
+	return selected;
+}
+
+static const LayoutKernelVariant &getLayoutKernels()
+{
+	static const LayoutKernelVariant &kernels = selectLayoutKernels();
+	return kernels;
+}
+
+void deinterleaveF32(const float *src, float *dst, size_t pixels, int channels)
+{
+	if (channels == 1) {
+		memcpy(dst, src, pixels * sizeof(float));
+	} else if (channels >= 2 && channels <= 4) {
+		getLayoutKernels().deinterleaveF32(src, dst, pixels, channels);
+	} else {
+		deinterleaveScalar(src, dst, pixels, channels);
+	}
+}
+
+void interleaveF32(const float *src, float *dst, size_t pixels, int channels)
+{
+	if (channels == 1) {
+		memcpy(dst, src, pixels * sizeof(float));
+	} else if (channels >= 2 && channels <= 4) {
+		getLayoutKernels().interleaveF32(src, dst, pixels, channels);
+	} else {
+		interleaveScalar(src, dst, pixels, channels);
+	}
+}
+
+void deinterleaveU8(const uint8_t *src, uint8_t *dst, size_t pixels,
+		    int channels)
+{
+	if (channels == 1) {
+		memcpy(dst, src, pixels);
+	} else if (channels >= 2 && channels <= 4) {
+		getLayoutKernels().deinterleaveU8(src, dst, pixels, channels);
+	} else {
+		deinterleaveScalar(src, dst, pixels, channels);
+	}
+}
+
+void interleaveU8(const uint8_t *src, uint8_t *dst, size_t pixels,
+		  int channels)
+{
+	if (channels == 1) {
+		memcpy(dst, src, pixels);
+	} else if (channels >= 2 && channels <= 4) {
+		getLayoutKernels().interleaveU8(src, dst, pixels, channels);
+	} else {
+		interleaveScalar(src, dst, pixels, channels);
+	}
+}
+
+const char *getLayoutKernelsName()
+{
+	return getLayoutKernels().name;
+}
+
+/**
+  * @brief Average time of one call of a kernel, in milliseconds
+*/
+template<typename T, typename Kernel>
+static double timeLayoutKernel(Kernel kernel, const std::vector<T> &src,
+			       std::vector<T> &dst, size_t pixels, int channels)
+{
+	const int runs = 20;
+	kernel(src.data(), dst.data(), pixels, channels);
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < runs; i++) {
+		kernel(src.data(), dst.data(), pixels, channels);
+	}
+	return std::chrono::duration<double, std::milli>(
+		       std::chrono::steady_clock::now() - start)
+		       .count() /
+	       runs;
+}
+
+template<typename T>
+static bool checkLayoutKernels(void (*deinterleave)(const T *, T *, size_t,
+						    int),
+			       void (*interleave)(const T *, T *, size_t, int),
+			       const std::vector<T> &src, size_t pixels,
+			       int channels, double &deinterleaveMs,
+			       double &interleaveMs)
+{
+	std::vector<T> planar(src.size()), expected(src.size()),
+		roundTrip(src.size());
+	deinterleaveMs = timeLayoutKernel(deinterleave, src, planar, pixels,
+					  channels);
+	interleaveMs = timeLayoutKernel(interleave, planar, roundTrip, pixels,
+					channels);
+	deinterleaveScalar(src.data(), expected.data(), pixels, channels);
+	return planar == expected && roundTrip == src;
+}
+
+void benchmarkLayoutKernels()
+{
+	// A 512x288 frame plus an odd tail, so the scalar remainder is exercised too
+	const size_t pixels = 512 * 288 + 7;
+
+	for (const LayoutKernelVariant &variant : getLayoutKernelVariants()) {
+		for (int channels = 2; channels <= 4; channels++) {
+			std::vector<float> srcF32(pixels * channels);
+			std::vector<uint8_t> srcU8(pixels * channels);
+			for (size_t i = 0; i < srcF32.size(); i++) {
+				srcF32[i] = (float)i;
+				srcU8[i] = (uint8_t)(i * 7);
+			}
+
+			double deinterleaveF32Ms, interleaveF32Ms;
+			double deinterleaveU8Ms, interleaveU8Ms;
+			const bool okF32 = checkLayoutKernels(
+				variant.deinterleaveF32, variant.interleaveF32,
+				srcF32, pixels, channels, deinterleaveF32Ms,
+				interleaveF32Ms);
+			const bool okU8 = checkLayoutKernels(
+				variant.deinterleaveU8, variant.interleaveU8,
+				srcU8, pixels, channels, deinterleaveU8Ms,
+				interleaveU8Ms);
+
+			obs_log(okF32 && okU8 ? LOG_INFO : LOG_ERROR,
+				"Layout kernels %s x%d: float %.3f / %.3f ms, uint8 %.3f / %.3f ms (deinterleave / interleave)%s",
+				variant.name, channels, deinterleaveF32Ms,
+				interleaveF32Ms, deinterleaveU8Ms,
+				interleaveU8Ms,
+				okF32 && okU8 ? ""
+					      : ", output differs from scalar");
+		}
+	}
+}
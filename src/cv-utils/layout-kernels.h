@@ -0,0 +1,36 @@
+#ifndef LAYOUT_KERNELS_H
+#define LAYOUT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+  * @brief Interleaved (HWC) to planar (CHW) conversion
+  *
+  * The planes are written one after the other: channel c of pixel i goes to
+  * dst[c * pixels + i]. 1-4 channels use the fastest SIMD kernel of the CPU,
+  * chosen once at load time, other channel counts use a scalar loop.
+*/
+void deinterleaveF32(const float *src, float *dst, size_t pixels, int channels);
+void deinterleaveU8(const uint8_t *src, uint8_t *dst, size_t pixels,
+		    int channels);
+
+/**
+  * @brief Planar (CHW) to interleaved (HWC) conversion, the inverse of deinterleave
+*/
+void interleaveF32(const float *src, float *dst, size_t pixels, int channels);
+void interleaveU8(const uint8_t *src, uint8_t *dst, size_t pixels,
+		  int channels);
+
+/**
+  * @brief Name of the kernel variant selected for this CPU, e.g. "AVX2"
+*/
+const char *getLayoutKernelsName();
+
+/**
+  * @brief Time every kernel variant this CPU can run on network-sized frames and
+  * check it against the scalar kernels. Results are logged.
+*/
+void benchmarkLayoutKernels();
+
+#endif /* LAYOUT_KERNELS_H */
@@ -0,0 +1,87 @@
+#include "mat-allocation-counter.h"
+
+#include <obs-module.h>
+
+#ifdef _DEBUG
+#include <opencv2/core.hpp>
+
+#include <cinttypes>
+#include <mutex>
+
+#include "plugin-support.h"
+
+static thread_local uint64_t matAllocationCount = 0;
+
+/**
+  * @brief Forwards to OpenCV's standard allocator, counting buffer allocations
+  *
+  * Buffers keep the standard allocator as their owner, so they are released through
+  * it directly even after this allocator is gone.
+*/
+class CountingMatAllocator : public cv::MatAllocator {
+public:
+	explicit CountingMatAllocator(cv::MatAllocator *base_) : base(base_) {}
+
+	cv::UMatData *allocate(int dims, const int *sizes, int type, void *data,
+			       size_t *step, cv::AccessFlag flags,
+			       cv::UMatUsageFlags usageFlags) const override
+	{
+		if (data == nullptr) {
+			// Headers over user memory (e.g. tensors) don't allocate a buffer
+			matAllocationCount++;
+		}
+		return base->allocate(dims, sizes, type, data, step, flags,
+				      usageFlags);
+	}
+
+	bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags,
+		      cv::UMatUsageFlags usageFlags) const override
+	{
+		return base->allocate(data, accessFlags, usageFlags);
+	}
+
+	void deallocate(cv::UMatData *data) const override
+	{
+		base->deallocate(data);
+	}
+
+private:
+	cv::MatAllocator *base;
+};
+
+void installMatAllocationCounter()
+{
+	static std::once_flag installed;
+	std::call_once(installed, [] {
+		// Intentionally leaked: Mats may outlive the plugin's static destructors
+		static CountingMatAllocator *allocator =
+			new CountingMatAllocator(cv::Mat::getStdAllocator());
+		cv::Mat::setDefaultAllocator(allocator);
+		obs_log(LOG_INFO, "Counting cv::Mat allocations (debug build)");
+	});
+}
+
+MatAllocationScope::MatAllocationScope(const char *name_)
+	: name(name_),
+	  startCount(matAllocationCount)
+{
+}
+
+MatAllocationScope::~MatAllocationScope()
+{
+	const uint64_t count = matAllocationCount - startCount;
+	if (count > 0) {
+		obs_log(LOG_DEBUG, "%s: %" PRIu64 " cv::Mat allocations", name,
+			count);
+	}
+}
+
+#else
+
+void installMatAllocationCounter() {}
+
+MatAllocationScope::MatAllocationScope(const char *) {}
+
+MatAllocationScope::~MatAllocationScope() {}
+
+#endif
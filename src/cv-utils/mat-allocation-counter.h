@@ -0,0 +1,36 @@
+#ifndef MAT_ALLOCATION_COUNTER_H
+#define MAT_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+/**
+  * @brief Wrap OpenCV's default allocator to count cv::Mat buffer allocations
+  *
+  * Only active in debug builds, it is used to verify that steady-state video ticks
+  * reuse their buffers instead of allocating. Safe to call more than once.
+  * In release builds this is a no-op.
+*/
+void installMatAllocationCounter();
+
+/**
+  * @brief Logs the cv::Mat buffer allocations made by the current thread while in scope
+  *
+  * Allocations are counted per thread, so other filters and the session builder
+  * don't pollute the count of a tick. Does nothing in release builds.
+*/
+class MatAllocationScope {
+public:
+	explicit MatAllocationScope(const char *name);
+	~MatAllocationScope();
+
+	MatAllocationScope(const MatAllocationScope &) = delete;
+	MatAllocationScope &operator=(const MatAllocationScope &) = delete;
+
+private:
+#ifdef _DEBUG
+	const char *name;
+	uint64_t startCount;
+#endif
+};
+
+#endif /* MAT_ALLOCATION_COUNTER_H */
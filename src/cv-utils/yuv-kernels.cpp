@@ -0,0 +1,206 @@
+#include "yuv-kernels.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+  * @brief Where the samples of a format are: the plane, and the byte step and offset
+  * of a sample in its row
+*/
+struct YuvLayout {
+	int lumaPlane, lumaStep, lumaOffset;
+	int uPlane, vPlane, chromaStep, uOffset, vOffset;
+	// Vertical chroma subsampling
+	int chromaRowsDiv;
+};
+
+static YuvLayout getYuvLayout(YuvFormat format)
+{
+	switch (format) {
+	case YUV_FORMAT_I420:
+		return {0, 1, 0, 1, 2, 1, 0, 0, 2};
+	case YUV_FORMAT_YUY2:
+		return {0, 2, 0, 0, 0, 4, 1, 3, 1};
+	case YUV_FORMAT_UYVY:
+		return {0, 2, 1, 0, 0, 4, 0, 2, 1};
+	case YUV_FORMAT_NV12:
+	default:
+		return {0, 1, 0, 1, 1, 2, 0, 1, 2};
+	}
+}
+
+void YuvImage::copyTo(YuvImage &dst) const
+{
+	dst.format = format;
+	for (int i = 0; i < 3; i++) {
+		if (planes[i].empty()) {
+			dst.planes[i].release();
+		} else {
+			planes[i].copyTo(dst.planes[i]);
+		}
+	}
+	std::copy(&colorMatrix[0][0], &colorMatrix[0][0] + 12,
+		  &dst.colorMatrix[0][0]);
+}
+
+void YuvImage::flipVertical()
+{
+	for (cv::Mat &plane : planes) {
+		if (!plane.empty()) {
+			cv::flip(plane, plane, 0);
+		}
+	}
+}
+
+void YuvImage::release()
+{
+	for (cv::Mat &plane : planes) {
+		plane.release();
+	}
+}
+
+/**
+  * @brief Bilinear taps of the output samples along one axis of a plane
+*/
+struct BilinearTaps {
+	std::vector<int> first, second;
+	std::vector<float> weight;
+};
+
+/**
+  * @brief Compute the taps of dstSize samples over a plane of planeSize samples,
+  * scaled to byte offsets by step and offset
+*/
+static void computeTaps(int dstSize, int planeSize, int step, int offset,
+			BilinearTaps &taps)
+{
+	taps.first.resize(dstSize);
+	taps.second.resize(dstSize);
+	taps.weight.resize(dstSize);
+	const double scale = (double)planeSize / (double)dstSize;
+	for (int i = 0; i < dstSize; i++) {
+		// Pixel centers are aligned, as in cv::resize
+		const double pos = std::max(0.0, ((double)i + 0.5) * scale - 0.5);
+		const int first = std::min((int)pos, planeSize - 1);
+		taps.first[i] = first * step + offset;
+		taps.second[i] = std::min(first + 1, planeSize - 1) * step + offset;
+		taps.weight[i] = (float)(pos - (double)first);
+	}
+}
+
+static inline float sampleBilinear(const uint8_t *row0, const uint8_t *row1,
+				   float rowWeight, const BilinearTaps &taps,
+				   int i)
+{
+	const float w = taps.weight[i];
+	const float top = (float)row0[taps.first[i]] +
+			  w * (float)(row0[taps.second[i]] -
+				      row0[taps.first[i]]);
+	const float bottom = (float)row1[taps.first[i]] +
+			     w * (float)(row1[taps.second[i]] -
+					 row1[taps.first[i]]);
+	return top + rowWeight * (bottom - top);
+}
+
+void yuvToNetworkRGB(const YuvImage &src, int width, int height, cv::Mat &rgb)
+{
+	rgb.create(height, width, CV_32FC3);
+	const YuvLayout layout = getYuvLayout(src.format);
+	const int chromaWidth = src.width() / 2;
+	const int chromaHeight = src.height() / layout.chromaRowsDiv;
+
+	// The taps only change with the sizes, but computing them is cheap next to
+	// the pass itself
+	BilinearTaps lumaColumns, chromaColumns, lumaRows, chromaRows;
+	computeTaps(width, src.width(), layout.lumaStep, layout.lumaOffset,
+		    lumaColumns);
+	computeTaps(width, chromaWidth, layout.chromaStep, 0, chromaColumns);
+	computeTaps(height, src.height(), 1, 0, lumaRows);
+	computeTaps(height, chromaHeight, 1, 0, chromaRows);
+
+	// The matrix for YUV and RGB in [0,255]
+	float m[3][4];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			m[i][j] = src.colorMatrix[i][j];
+		}
+		m[i][3] = src.colorMatrix[i][3] * 255.0f;
+	}
+
+	const cv::Mat &lumaPlane = src.planes[layout.lumaPlane];
+	const cv::Mat &uPlane = src.planes[layout.uPlane];
+	const cv::Mat &vPlane = src.planes[layout.vPlane];
+	for (int y = 0; y < height; y++) {
+		const uint8_t *luma0 = lumaPlane.ptr<uint8_t>(lumaRows.first[y]);
+		const uint8_t *luma1 =
+			lumaPlane.ptr<uint8_t>(lumaRows.second[y]);
+		const float lumaWeight = lumaRows.weight[y];
+		const uint8_t *u0 = uPlane.ptr<uint8_t>(chromaRows.first[y]) +
+				    layout.uOffset;
+		const uint8_t *u1 = uPlane.ptr<uint8_t>(chromaRows.second[y]) +
+				    layout.uOffset;
+		const uint8_t *v0 = vPlane.ptr<uint8_t>(chromaRows.first[y]) +
+				    layout.vOffset;
+		const uint8_t *v1 = vPlane.ptr<uint8_t>(chromaRows.second[y]) +
+				    layout.vOffset;
+		const float chromaWeight = chromaRows.weight[y];
+
+		float *out = rgb.ptr<float>(y);
+		for (int x = 0; x < width; x++) {
+			const float Y = sampleBilinear(luma0, luma1, lumaWeight,
+						       lumaColumns, x);
+			const float U = sampleBilinear(u0, u1, chromaWeight,
+						       chromaColumns, x);
+			const float V = sampleBilinear(v0, v1, chromaWeight,
+						       chromaColumns, x);
+			for (int c = 0; c < 3; c++) {
+				const float value = m[c][0] * Y + m[c][1] * U +
+						    m[c][2] * V + m[c][3];
+				out[3 * x + c] =
+					std::min(255.0f, std::max(0.0f, value));
+			}
+		}
+	}
+}
+
+const cv::Mat &yuvLuma(const YuvImage &src, cv::Mat &scratch)
+{
+	if (src.format == YUV_FORMAT_NV12 || src.format == YUV_FORMAT_I420) {
+		return src.planes[0];
+	}
+	cv::extractChannel(src.planes[0], scratch,
+			   getYuvLayout(src.format).lumaOffset);
+	return scratch;
+}
+
+void yuvToBGRA(const YuvImage &src, cv::Mat &scratch, cv::Mat &bgra)
+{
+	const int width = src.width();
+	const int height = src.height();
+	switch (src.format) {
+	case YUV_FORMAT_NV12:
+		cv::cvtColorTwoPlane(src.planes[0], src.planes[1], bgra,
+				     cv::COLOR_YUV2BGRA_NV12);
+		break;
+	case YUV_FORMAT_I420: {
+		// OpenCV takes the three planes back to back
+		scratch.create(height * 3 / 2, width, CV_8UC1);
+		uint8_t *planeData = scratch.data;
+		for (const cv::Mat &plane : src.planes) {
+			plane.copyTo(cv::Mat(plane.size(), CV_8UC1, planeData));
+			planeData += plane.total();
+		}
+		cv::cvtColor(scratch, bgra, cv::COLOR_YUV2BGRA_I420);
+		break;
+	}
+	case YUV_FORMAT_YUY2:
+		cv::cvtColor(src.planes[0], bgra, cv::COLOR_YUV2BGRA_YUY2);
+		break;
+	case YUV_FORMAT_UYVY:
+		cv::cvtColor(src.planes[0], bgra, cv::COLOR_YUV2BGRA_UYVY);
+		break;
+	}
+}
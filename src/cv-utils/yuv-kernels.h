@@ -0,0 +1,75 @@
+#ifndef YUV_KERNELS_H
+#define YUV_KERNELS_H
+
+#include <opencv2/core.hpp>
+
+enum YuvFormat {
+	// Luma plane and an interleaved CbCr plane, both subsampled 2x2
+	YUV_FORMAT_NV12 = 0,
+	// Luma, Cb and Cr planes, the chroma subsampled 2x2
+	YUV_FORMAT_I420,
+	// Packed Y0 Cb Y1 Cr
+	YUV_FORMAT_YUY2,
+	// Packed Cb Y0 Cr Y1
+	YUV_FORMAT_UYVY,
+};
+
+/**
+  * @brief A camera frame in its own YUV layout
+  *
+  * NV12 and I420 keep their planes in planes[0..2]. The packed formats are a single
+  * CV_8UC2 plane of one (luma, chroma) pair per pixel. Width and height are even.
+*/
+struct YuvImage {
+	YuvFormat format = YUV_FORMAT_NV12;
+	cv::Mat planes[3];
+	// Rows of the YUV to RGB matrix, for YUV and RGB in [0,1]:
+	// rgb[i] = colorMatrix[i][0..2] . yuv + colorMatrix[i][3]. BT.601 limited range
+	// by default.
+	float colorMatrix[3][4] = {{1.164384f, 0.0f, 1.596027f, -0.874202f},
+				   {1.164384f, -0.391762f, -0.812968f, 0.531668f},
+				   {1.164384f, 2.017232f, 0.0f, -1.085631f}};
+
+	int width() const { return planes[0].cols; }
+	int height() const { return planes[0].rows; }
+	cv::Size size() const { return planes[0].size(); }
+	bool empty() const { return planes[0].empty(); }
+
+	/**
+	  * @brief Deep copy, reusing the buffers of dst while the size doesn't change
+	*/
+	void copyTo(YuvImage &dst) const;
+	void flipVertical();
+	void release();
+};
+
+/**
+  * @brief Resample a YUV frame to the network input size and convert it to RGB float
+  * in [0,255], in one pass
+  *
+  * Bilinear like the cv::resize of BGRA frames, with the frame's own color matrix.
+  * Replaces the readback, BGRA to RGB conversion, resize and float conversion of a
+  * camera frame by a pass over the network-sized output.
+  *
+  * @param rgb The CV_32FC3 RGB image
+*/
+void yuvToNetworkRGB(const YuvImage &src, int width, int height, cv::Mat &rgb);
+
+/**
+  * @brief The luma of a YUV frame, the plane itself for the planar formats
+  *
+  * @param scratch Receives the luma of the packed formats
+*/
+const cv::Mat &yuvLuma(const YuvImage &src, cv::Mat &scratch);
+
+/**
+  * @brief Convert a YUV frame to BGRA at its resolution, for the code that needs the
+  * full frame
+  *
+  * This uses OpenCV's BT.601 limited range conversion rather than the frame's matrix.
+  *
+  * @param scratch Buffer to gather the I420 planes in
+*/
+void yuvToBGRA(const YuvImage &src, cv::Mat &scratch, cv::Mat &bgra);
+
+#endif /* YUV_KERNELS_H */
@@ -14,4 +14,5 @@ struct obs_source_info enhance_filter_info = {
 	.deactivate = enhance_filter_deactivate,
 	.video_tick = enhance_filter_video_tick,
 	.video_render = enhance_filter_video_render,
+	.filter_video = enhance_filter_video,
 };
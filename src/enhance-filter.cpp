@@ -19,18 +19,47 @@
 #include <plugin-support.h>
 #include "consts.h"
 #include "obs-utils/obs-utils.h"
+#include "obs-utils/shared-results.h"
+#include "cv-utils/mat-allocation-counter.h"
 #include "ort-utils/ort-session-utils.h"
-#include "models/ModelTBEFN.h"
-#include "models/ModelZeroDCE.h"
-#include "models/ModelURetinex.h"
+#include "models/ModelRegistry.h"
 #include "update-checker/update-checker.h"
 
 struct enhance_filter : public filter_data {
 	cv::Mat outputBGRA;
+	// outputBGRA holds packed Zero-DCE curve parameters (CV_32FC4) instead of an image
+	bool outputIsCurves = false;
 	gs_effect_t *blendEffect;
 	float blendFactor;
+
+	int enhanceEveryXFrames = 1;
+	int enhanceEveryXFramesCount = 0;
+	float sceneChangeThreshold = 10.0f;
+	// Thumbnail of the last frame that went through the network
+	cv::Mat lastThumbnail;
+	// Per-pixel gain (enhanced / input) of the last inference, at network resolution
+	cv::Mat gainMap;
+	// The last inference produced curve parameters (tick thread only)
+	bool curveOutput = false;
+
+	// Per-tick buffers, reused across frames so steady-state ticks don't allocate
+	cv::Mat frameBGRA;
+	cv::Mat thumbnailBGRA;
+	cv::Mat thumbnail;
+	cv::Mat modelOutput;
+	cv::Mat resizedBGRA;
+	cv::Mat resizedRGB;
+	cv::Mat inputF;
+	cv::Mat enhancedF;
 };
 
+// Size of the grayscale thumbnail used for scene-change detection
+static const cv::Size SCENE_THUMBNAIL_SIZE(64, 36);
+// Gains above this are dark-noise amplification rather than enhancement
+static const float MAX_ENHANCE_GAIN = 16.0f;
+// Iterations of the Zero-DCE curve models: 8 x RGB parameters, as in the shader
+static const int ZERO_DCE_CURVE_ITERATIONS = 8;
+
 const char *enhance_filter_getname(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -39,30 +68,40 @@ const char *enhance_filter_getname(void *unused)
 
 obs_properties_t *enhance_filter_properties(void *data)
 {
-	UNUSED_PARAMETER(data);
 	obs_properties_t *props = obs_properties_create();
 	obs_properties_add_float_slider(props, "blend",
 					obs_module_text("EffectStrengh"), 0.0,
 					1.0, 0.05);
 	obs_properties_add_int_slider(props, "numThreads",
 				      obs_module_text("NumThreads"), 0, 8, 1);
+	obs_properties_add_int_slider(props, "warmup_runs",
+				      obs_module_text("WarmupRuns"), 0, 10, 1);
+	obs_properties_add_int(props, "enhance_every_x_frames",
+			       obs_module_text("EnhanceEveryXFrames"), 1, 30,
+			       1);
+	obs_properties_add_float_slider(props, "scene_change_threshold",
+					obs_module_text("SceneChangeThreshold"),
+					0.0, 50.0, 0.5);
 	obs_property_t *p_model_select = obs_properties_add_list(
 		props, "model_select", obs_module_text("EnhancementModel"),
 		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
-	obs_property_list_add_string(p_model_select, obs_module_text("TBEFN"),
-				     MODEL_ENHANCE_TBEFN);
-	obs_property_list_add_string(p_model_select,
-				     obs_module_text("URETINEX"),
-				     MODEL_ENHANCE_URETINEX);
-	obs_property_list_add_string(p_model_select, obs_module_text("SGLLIE"),
-				     MODEL_ENHANCE_SGLLIE);
-	obs_property_list_add_string(p_model_select, obs_module_text("ZERODCE"),
-				     MODEL_ENHANCE_ZERODCE);
+	addModelsToList(p_model_select, MODEL_FILTER_ENHANCE);
 	obs_property_t *p_use_gpu = obs_properties_add_list(
 		props, "useGPU", obs_module_text("InferenceDevice"),
 		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
 	obs_property_list_add_string(p_use_gpu, obs_module_text("CPU"),
 				     USEGPU_CPU);
+	// Alternative CPU providers, only if the ONNX Runtime build includes them
+	if (isExecutionProviderAvailable(USEGPU_XNNPACK)) {
+		obs_property_list_add_string(p_use_gpu,
+					     obs_module_text("CPUXNNPACK"),
+					     USEGPU_XNNPACK);
+	}
+	if (isExecutionProviderAvailable(USEGPU_DNNL)) {
+		obs_property_list_add_string(p_use_gpu,
+					     obs_module_text("CPUOneDNN"),
+					     USEGPU_DNNL);
+	}
 #ifdef __linux__
 	obs_property_list_add_string(p_use_gpu, obs_module_text("GPUTensorRT"),
 				     USEGPU_TENSORRT);
@@ -91,13 +130,23 @@ obs_properties_t *enhance_filter_properties(void *data)
 	obs_properties_add_text(props, "info", basic_info.c_str(),
 				OBS_TEXT_INFO);
 
+	if (data != nullptr) {
+		struct enhance_filter *tf =
+			reinterpret_cast<enhance_filter *>(data);
+		addTimeToFirstOutputInfo(props, tf);
+	}
+
 	return props;
 }
 
 void enhance_filter_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_double(settings, "blend", 1.0);
-	obs_data_set_default_int(settings, "numThreads", 1);
+	// 0 shares the plugin's thread pool, sized to the CPU budget
+	obs_data_set_default_int(settings, "numThreads", 0);
+	obs_data_set_default_int(settings, "warmup_runs", 2);
+	obs_data_set_default_int(settings, "enhance_every_x_frames", 1);
+	obs_data_set_default_double(settings, "scene_change_threshold", 10.0);
 	obs_data_set_default_string(settings, "model_select",
 				    MODEL_ENHANCE_TBEFN);
 #if _WIN32
@@ -122,34 +171,102 @@ void enhance_filter_deactivate(void *data)
 	tf->isDisabled = true;
 }
 
+/**
+  * @brief Request a session build in the background, unless the same model, device and
+  * threads were already requested
+  *
+  * @return true if a new build was requested
+*/
+static bool requestSession(struct enhance_filter *tf,
+			   const std::string &modelSelection,
+			   const std::string &useGPU, uint32_t numThreads,
+			   uint32_t warmupRuns)
+{
+	const ModelDescriptor *descriptor = findModelDescriptor(modelSelection);
+	if (!descriptor) {
+		obs_log(LOG_ERROR, "Model %s is not in the model registry",
+			modelSelection.c_str());
+		return false;
+	}
+
+	const std::string sessionKey = modelSelection + "|" + useGPU + "|" +
+				       std::to_string(numThreads);
+	{
+		std::lock_guard<std::mutex> lock(tf->requestedSessionKeyLock);
+		if (tf->requestedSessionKey == sessionKey) {
+			return false;
+		}
+		tf->requestedSessionKey = sessionKey;
+	}
+
+	std::unique_ptr<ORTModelData> staged(new ORTModelData);
+	staged->modelSelection = modelSelection;
+	staged->useGPU = useGPU;
+	staged->numThreads = numThreads;
+	staged->warmupRuns = warmupRuns;
+	staged->requestTime = std::chrono::steady_clock::now();
+	staged->env = tf->env;
+
+	staged->model = createModel(*descriptor);
+	if (!staged->model) {
+		return false;
+	}
+
+	tf->sessionBuilder->request(std::move(staged));
+	return true;
+}
+
+/**
+  * @brief Rebuild the session on the next execution provider in the fallback chain,
+  * after the current one failed at runtime
+*/
+static void fallbackToNextProvider(struct enhance_filter *tf)
+{
+	std::string modelSelection, activeProvider;
+	uint32_t numThreads, warmupRuns;
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		modelSelection = tf->modelSelection;
+		activeProvider = tf->activeProvider;
+		numThreads = tf->numThreads;
+		warmupRuns = tf->warmupRuns;
+	}
+	const std::string nextProvider =
+		getNextExecutionProvider(activeProvider);
+	if (nextProvider.empty()) {
+		return;
+	}
+	// Settings changes keep requesting it, until the device setting changes
+	tf->setFallbackProvider(nextProvider);
+	if (requestSession(tf, modelSelection, nextProvider, numThreads,
+			   warmupRuns)) {
+		obs_log(LOG_WARNING,
+			"Execution provider %s failed at runtime, falling back to %s",
+			activeProvider.c_str(), nextProvider.c_str());
+	}
+}
+
 void enhance_filter_update(void *data, obs_data_t *settings)
 {
 	UNUSED_PARAMETER(settings);
 	struct enhance_filter *tf = reinterpret_cast<enhance_filter *>(data);
 
 	tf->blendFactor = (float)obs_data_get_double(settings, "blend");
+	tf->enhanceEveryXFrames =
+		(int)obs_data_get_int(settings, "enhance_every_x_frames");
+	tf->enhanceEveryXFramesCount = 0;
+	tf->sceneChangeThreshold =
+		(float)obs_data_get_double(settings, "scene_change_threshold");
 	const uint32_t newNumThreads =
 		(uint32_t)obs_data_get_int(settings, "numThreads");
 	const std::string newModel =
 		obs_data_get_string(settings, "model_select");
-	const std::string newUseGpu = obs_data_get_string(settings, "useGPU");
-
-	if (tf->modelSelection.empty() || tf->modelSelection != newModel ||
-	    tf->useGPU != newUseGpu || tf->numThreads != newNumThreads) {
-		tf->numThreads = newNumThreads;
-		tf->modelSelection = newModel;
-		if (tf->modelSelection == MODEL_ENHANCE_TBEFN) {
-			tf->model.reset(new ModelTBEFN);
-		} else if (tf->modelSelection == MODEL_ENHANCE_ZERODCE) {
-			tf->model.reset(new ModelZeroDCE);
-		} else if (tf->modelSelection == MODEL_ENHANCE_URETINEX) {
-			tf->model.reset(new ModelURetinex);
-		} else {
-			tf->model.reset(new ModelBCHW);
-		}
-		tf->useGPU = newUseGpu;
-		createOrtSession(tf);
-	}
+	const std::string newUseGpu = tf->resolveExecutionProvider(
+		obs_data_get_string(settings, "useGPU"));
+
+	// Build the new session in the background, the current one keeps running until then
+	requestSession(tf, newModel, newUseGpu, newNumThreads,
+		       (uint32_t)obs_data_get_int(settings, "warmup_runs"));
 
 	if (tf->blendEffect == nullptr) {
 		obs_enter_graphics();
@@ -167,12 +284,24 @@ void *enhance_filter_create(obs_data_t *settings, obs_source_t *source)
 	void *data = bmalloc(sizeof(struct enhance_filter));
 	struct enhance_filter *tf = new (data) enhance_filter();
 
+	installMatAllocationCounter();
+
 	tf->source = source;
 	tf->texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
 
-	std::string instanceName{"enhance-portrait-inference"};
-	tf->env.reset(new Ort::Env(OrtLoggingLevel::ORT_LOGGING_LEVEL_ERROR,
-				   instanceName.c_str()));
+	tf->env = getSharedOrtEnv();
+
+	tf->sessionBuilder.reset(new OrtSessionBuilder(
+		[tf](std::unique_ptr<ORTModelData> &built, int result) {
+			if (result != OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+				obs_log(LOG_ERROR,
+					"Failed to create ONNXRuntime session. Error code: %d",
+					result);
+				return;
+			}
+			std::lock_guard<std::mutex> lock(tf->modelMutex);
+			tf->swapSession(*built);
+		}));
 
 	enhance_filter_update(tf, settings);
 
@@ -184,6 +313,9 @@ void enhance_filter_destroy(void *data)
 	struct enhance_filter *tf = reinterpret_cast<enhance_filter *>(data);
 
 	if (tf) {
+		tf->sessionBuilder.reset();
+		releaseSharedResults(tf);
+
 		obs_enter_graphics();
 		gs_texrender_destroy(tf->texrender);
 		if (tf->stagesurface) {
@@ -196,6 +328,74 @@ void enhance_filter_destroy(void *data)
 	}
 }
 
+/**
+  * @brief Resize a frame to the network output resolution, in the network's RGB order
+  *
+  * The result is in tf->resizedRGB.
+*/
+static void frameToNetworkRGB(struct enhance_filter *tf,
+			      const cv::Mat &imageBGRA, const cv::Size &size)
+{
+	cv::resize(imageBGRA, tf->resizedBGRA, size, 0, 0, cv::INTER_AREA);
+	cv::cvtColor(tf->resizedBGRA, tf->resizedRGB, cv::COLOR_BGRA2RGB);
+}
+
+/**
+  * @brief Compute the per-pixel gain that turns the input frame into the enhanced one
+  *
+  * @param imageBGRA The input frame
+  * @param enhancedRGB The network output (CV_8UC3, network resolution)
+  * @param gainMap The gain (CV_32FC3, network resolution)
+*/
+static void computeGainMap(struct enhance_filter *tf,
+			   const cv::Mat &imageBGRA, const cv::Mat &enhancedRGB,
+			   cv::Mat &gainMap)
+{
+	// Offset by 1 so black pixels don't divide by zero
+	frameToNetworkRGB(tf, imageBGRA, enhancedRGB.size());
+	tf->resizedRGB.convertTo(tf->inputF, CV_32F, 1.0, 1.0);
+	enhancedRGB.convertTo(tf->enhancedF, CV_32F, 1.0, 1.0);
+	cv::divide(tf->enhancedF, tf->inputF, gainMap);
+	cv::threshold(gainMap, gainMap, MAX_ENHANCE_GAIN, MAX_ENHANCE_GAIN,
+		      cv::THRESH_TRUNC);
+	// Lighting gain is smooth, blurring it keeps edges from ghosting on motion
+	cv::blur(gainMap, gainMap, cv::Size(3, 3));
+}
+
+/**
+  * @brief Enhance a frame by applying the gain map of the last inference
+*/
+static void applyGainMap(struct enhance_filter *tf, const cv::Mat &imageBGRA,
+			 const cv::Mat &gainMap, cv::Mat &outputRGB)
+{
+	frameToNetworkRGB(tf, imageBGRA, gainMap.size());
+	tf->resizedRGB.convertTo(tf->inputF, CV_32F, 1.0, 1.0);
+	cv::multiply(tf->inputF, gainMap, tf->inputF);
+	tf->inputF.convertTo(outputRGB, CV_8U, 1.0, -1.0);
+}
+
+/**
+  * @brief Pack the Zero-DCE curve parameters into a float RGBA texture atlas
+  *
+  * The parameters stay in float: quantizing them to 8 bits shifts every iteration's
+  * curve, and the error compounds over the iterations.
+  *
+  * @param curves The parameters (CV_32FC(24) in [0,1], network resolution), 3 channels per iteration
+  * @param atlasRGBA One RGB tile per iteration, stacked vertically (CV_32FC4)
+*/
+static void packCurveTiles(const cv::Mat &curves, cv::Mat &atlasRGBA)
+{
+	const int iterations = curves.channels() / 3;
+	atlasRGBA.create(curves.rows * iterations, curves.cols, CV_32FC4);
+	atlasRGBA.setTo(cv::Scalar(0, 0, 0, 1));
+	for (int i = 0; i < iterations; i++) {
+		cv::Mat tile =
+			atlasRGBA.rowRange(i * curves.rows, (i + 1) * curves.rows);
+		const int fromTo[] = {3 * i, 0, 3 * i + 1, 1, 3 * i + 2, 2};
+		cv::mixChannels(&curves, 1, &tile, 1, fromTo, 3);
+	}
+}
+
 void enhance_filter_video_tick(void *data, float seconds)
 {
 	UNUSED_PARAMETER(seconds);
@@ -213,25 +413,74 @@ void enhance_filter_video_tick(void *data, float seconds)
 		return;
 	}
 
+	MatAllocationScope allocationScope("Enhance filter tick");
+
 	// Get input image from source rendering pipeline
-	cv::Mat imageBGRA;
+	cv::Mat &imageBGRA = tf->frameBGRA;
 	{
 		std::unique_lock<std::mutex> lock(tf->inputBGRALock,
 						  std::try_to_lock);
 		if (!lock.owns_lock()) {
 			return;
 		}
-		imageBGRA = tf->inputBGRA.clone();
+		tf->inputBGRA.copyTo(imageBGRA);
+		tf->frameTime = tf->inputFrameTime;
+	}
+
+	// Run the network every X frames, or right away on a scene change.
+	// In between, the last enhancement is reapplied to the new frame as a gain map.
+	cv::Mat &thumbnail = tf->thumbnail;
+	cv::resize(imageBGRA, tf->thumbnailBGRA, SCENE_THUMBNAIL_SIZE, 0, 0,
+		   cv::INTER_AREA);
+	cv::cvtColor(tf->thumbnailBGRA, thumbnail, cv::COLOR_BGRA2GRAY);
+
+	tf->enhanceEveryXFramesCount++;
+	tf->enhanceEveryXFramesCount %= tf->enhanceEveryXFrames;
+
+	bool runInference =
+		tf->enhanceEveryXFramesCount == 0 ||
+		tf->lastThumbnail.empty() ||
+		(tf->gainMap.empty() && !tf->curveOutput);
+	if (!runInference) {
+		// Mean absolute difference from the last enhanced frame, in [0,255]
+		const double sceneChange =
+			cv::norm(thumbnail, tf->lastThumbnail, cv::NORM_L1) /
+			(double)thumbnail.total();
+		runInference = sceneChange > tf->sceneChangeThreshold;
 	}
 
-	cv::Mat outputImage;
-	try {
-		if (!runFilterModelInference(tf, imageBGRA, outputImage)) {
+	cv::Mat &outputImage = tf->modelOutput;
+	if (runInference) {
+		try {
+			std::lock_guard<std::mutex> lock(tf->modelMutex);
+			if (!runSharedModelInference(tf, imageBGRA, "",
+						     outputImage)) {
+				return;
+			}
+			const ModelDescriptor *descriptor =
+				findModelDescriptor(tf->modelSelection);
+			tf->curveOutput = descriptor &&
+					  descriptor->outputIsCurves;
+		} catch (const Ort::Exception &e) {
+			obs_log(LOG_ERROR, "ONNXRuntime Exception: %s",
+				e.what());
+			fallbackToNextProvider(tf);
+			return;
+		} catch (const std::exception &e) {
+			obs_log(LOG_ERROR, "Exception caught: %s", e.what());
 			return;
 		}
-	} catch (const std::exception &e) {
-		obs_log(LOG_ERROR, "Exception caught: %s", e.what());
+		thumbnail.copyTo(tf->lastThumbnail);
+		if (tf->curveOutput) {
+			tf->gainMap.release();
+		} else {
+			computeGainMap(tf, imageBGRA, outputImage, tf->gainMap);
+		}
+	} else if (tf->curveOutput) {
+		// The shader applies the last curves to every new frame already
 		return;
+	} else {
+		applyGainMap(tf, imageBGRA, tf->gainMap, outputImage);
 	}
 
 	// Put output image back to source rendering pipeline
@@ -242,11 +491,24 @@ void enhance_filter_video_tick(void *data, float seconds)
 			return;
 		}
 
-		// convert to RGBA
-		cv::cvtColor(outputImage, tf->outputBGRA, cv::COLOR_BGR2RGBA);
+		tf->outputIsCurves = tf->curveOutput;
+		if (tf->curveOutput) {
+			packCurveTiles(outputImage, tf->outputBGRA);
+		} else {
+			// convert to RGBA
+			cv::cvtColor(outputImage, tf->outputBGRA,
+				     cv::COLOR_BGR2RGBA);
+		}
 	}
 }
 
+struct obs_source_frame *enhance_filter_video(void *data,
+					      struct obs_source_frame *frame)
+{
+	struct enhance_filter *tf = reinterpret_cast<enhance_filter *>(data);
+	return filterAsyncVideo(tf, frame);
+}
+
 void enhance_filter_video_render(void *data, gs_effect_t *_effect)
 {
 	UNUSED_PARAMETER(_effect);
@@ -255,11 +517,20 @@ void enhance_filter_video_render(void *data, gs_effect_t *_effect)
 
 	// Get input from source
 	uint32_t width, height;
-	if (!getRGBAFromStageSurface(tf, width, height)) {
+	if (!getInputFrame(tf, width, height, false)) {
 		obs_source_skip_video_filter(tf->source);
 		return;
 	}
 
+	{
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		if (tf->outputBGRA.empty()) {
+			// No enhanced frame yet (the session is still being built)
+			obs_source_skip_video_filter(tf->source);
+			return;
+		}
+	}
+
 	// Engage filter
 	if (!obs_source_process_filter_begin(tf->source, GS_RGBA,
 					     OBS_ALLOW_DIRECT_RENDERING)) {
@@ -269,10 +540,13 @@ void enhance_filter_video_render(void *data, gs_effect_t *_effect)
 
 	// Get output from neural network into texture
 	gs_texture_t *outputTexture = nullptr;
+	bool outputIsCurves = false;
 	{
 		std::lock_guard<std::mutex> lock(tf->outputLock);
+		outputIsCurves = tf->outputIsCurves;
 		outputTexture = gs_texture_create(
-			tf->outputBGRA.cols, tf->outputBGRA.rows, GS_BGRA, 1,
+			tf->outputBGRA.cols, tf->outputBGRA.rows,
+			outputIsCurves ? GS_RGBA32F : GS_BGRA, 1,
 			(const uint8_t **)&tf->outputBGRA.data, 0);
 		if (!outputTexture) {
 			obs_log(LOG_ERROR, "Failed to create output texture");
@@ -290,17 +564,31 @@ void enhance_filter_video_render(void *data, gs_effect_t *_effect)
 	gs_eparam_t *yOffset =
 		gs_effect_get_param_by_name(tf->blendEffect, "yOffset");
 
-	gs_effect_set_texture(blendimage, outputTexture);
 	gs_effect_set_float(blendFactor, tf->blendFactor);
-	gs_effect_set_float(xOffset, 1.0f / float(width));
-	gs_effect_set_float(yOffset, 1.0f / float(height));
+	if (outputIsCurves) {
+		// Apply the curves to the full resolution source, no high pass needed
+		gs_eparam_t *curveimage = gs_effect_get_param_by_name(
+			tf->blendEffect, "curveimage");
+		gs_eparam_t *curveHalfTexel = gs_effect_get_param_by_name(
+			tf->blendEffect, "curveHalfTexel");
+		const uint32_t tileHeight =
+			gs_texture_get_height(outputTexture) /
+			ZERO_DCE_CURVE_ITERATIONS;
+		gs_effect_set_texture(curveimage, outputTexture);
+		gs_effect_set_float(curveHalfTexel, 0.5f / float(tileHeight));
+	} else {
+		gs_effect_set_texture(blendimage, outputTexture);
+		gs_effect_set_float(xOffset, 1.0f / float(width));
+		gs_effect_set_float(yOffset, 1.0f / float(height));
+	}
 
 	// Render texture
 	gs_blend_state_push();
 	gs_reset_blend_state();
 
 	obs_source_process_filter_tech_end(tf->source, tf->blendEffect, 0, 0,
-					   "Draw");
+					   outputIsCurves ? "DrawCurves"
+							  : "Draw");
 
 	gs_blend_state_pop();
 
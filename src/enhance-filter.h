@@ -14,6 +14,8 @@ void enhance_filter_activate(void *data);
 void enhance_filter_deactivate(void *data);
 void enhance_filter_video_tick(void *data, float seconds);
 void enhance_filter_video_render(void *data, gs_effect_t *_effect);
+struct obs_source_frame *enhance_filter_video(void *data,
+					      struct obs_source_frame *frame);
 
 #ifdef __cplusplus
 }
@@ -11,6 +11,8 @@
 #include <opencv2/imgproc.hpp>
 #include <algorithm>
 
+#include "cv-utils/layout-kernels.h"
+
 template<typename T> T vectorProduct(const std::vector<T> &v)
 {
 	T product = 1;
@@ -23,18 +25,36 @@ template<typename T> T vectorProduct(const std::vector<T> &v)
 	return product;
 }
 
+/**
+* Convert a HWC Mat to CHW
+* The output is a single row holding the channels one after the other.
+* Writes into dst without temporaries, so a reused dst does not allocate.
+* @param src Input Mat, HWC
+* @param dst Output Mat, 1 x (C * H * W), same depth as src
+*/
 static void hwc_to_chw(cv::InputArray src, cv::OutputArray dst)
 {
-	std::vector<cv::Mat> channels;
-	cv::split(src, channels);
-
-	// Stretch one-channel images to vector
-	for (auto &img : channels) {
-		img = img.reshape(1, 1);
+	cv::Mat srcMat = src.getMat();
+	if (!srcMat.isContinuous()) {
+		srcMat = srcMat.clone();
+	}
+	const int channels = srcMat.channels();
+	const int pixels = srcMat.rows * srcMat.cols;
+
+	dst.create(1, channels * pixels, srcMat.depth());
+	cv::Mat dstMat = dst.getMat();
+
+	if (channels <= 4 && srcMat.depth() == CV_32F) {
+		deinterleaveF32(srcMat.ptr<float>(), dstMat.ptr<float>(),
+				pixels, channels);
+	} else if (channels <= 4 && srcMat.depth() == CV_8U) {
+		deinterleaveU8(srcMat.ptr<uint8_t>(), dstMat.ptr<uint8_t>(),
+			       pixels, channels);
+	} else {
+		// (H * W) x C -> C x (H * W)
+		cv::Mat dstPlanes = dstMat.reshape(1, channels);
+		cv::transpose(srcMat.reshape(1, pixels), dstPlanes);
 	}
-
-	// Concatenate three vectors to one
-	cv::hconcat(channels, dst);
 }
 
 /**
@@ -51,22 +71,19 @@ static void chw_to_hwc_32f(cv::InputArray src, cv::OutputArray dst)
 	const int channels = srcMat.channels();
 	const int height = srcMat.rows;
 	const int width = srcMat.cols;
-	const int dtype = srcMat.type();
-	assert(dtype == CV_32F);
-	const int channelStride = height * width;
-
-	// Flatten to a vector of channels
-	cv::Mat flatMat = srcMat.reshape(1, 1);
-
-	std::vector<cv::Mat> channelsVec(channels);
-	// Split the vector into channels
-	for (int i = 0; i < channels; i++) {
-		channelsVec[i] =
-			cv::Mat(height, width, CV_MAKE_TYPE(dtype, 1),
-				flatMat.ptr<float>(0) + i * channelStride);
+	assert(srcMat.depth() == CV_32F);
+
+	dst.create(height, width, CV_MAKE_TYPE(CV_32F, channels));
+	cv::Mat dstMat = dst.getMat();
+
+	if (channels <= 4) {
+		interleaveF32(srcMat.ptr<float>(), dstMat.ptr<float>(),
+			      (size_t)height * width, channels);
+	} else {
+		// C x (H * W) -> (H * W) x C, blocked transpose for wide tensors
+		cv::Mat dstPixels = dstMat.reshape(1, height * width);
+		cv::transpose(srcMat.reshape(1, channels), dstPixels);
 	}
-
-	cv::merge(channelsVec, dst);
 }
 
 /**
@@ -91,6 +108,17 @@ public:
 
 	const char *name;
 
+	// Inference resolution requested for models with dynamic spatial input dims,
+	// 0 keeps the model's own resolution
+	uint32_t requestedWidth = 0;
+	uint32_t requestedHeight = 0;
+	// Set by populateInputOutputShapes if the input height and width are dynamic
+	bool dynamicSpatialDims = false;
+
+	// Post-processing buffers, reused across frames
+	cv::Mat postprocessScratch;
+	cv::Mat channelScratch;
+
 #if _WIN32
 	const std::wstring
 #else
@@ -160,13 +188,6 @@ public:
 			outputTypeInfo.GetTensorTypeAndShapeInfo();
 		outputDims[0] = outputTensorInfo.GetShape();
 
-		// fix any -1 values in outputDims to 1
-		for (auto &i : outputDims[0]) {
-			if (i == -1) {
-				i = 1;
-			}
-		}
-
 		// Get input shape
 		const Ort::TypeInfo inputTypeInfo =
 			session->GetInputTypeInfo(0);
@@ -174,6 +195,15 @@ public:
 			inputTypeInfo.GetTensorTypeAndShapeInfo();
 		inputDims[0] = inputTensorInfo.GetShape();
 
+		applyRequestedSpatialDims(inputDims, outputDims);
+
+		// fix any -1 values in outputDims to 1
+		for (auto &i : outputDims[0]) {
+			if (i == -1) {
+				i = 1;
+			}
+		}
+
 		// fix any -1 values in inputDims to 1
 		for (auto &i : inputDims[0]) {
 			if (i == -1) {
@@ -191,6 +221,57 @@ public:
 		return true;
 	}
 
+	/**
+	  * @brief Get the positions of the height and width in the input shape
+	*/
+	virtual void getInputSpatialDimIndices(size_t &heightIndex,
+					       size_t &widthIndex)
+	{
+		// BHWC
+		heightIndex = 1;
+		widthIndex = 2;
+	}
+
+	/**
+	  * @brief Get the positions of the height and width in the output shape
+	*/
+	virtual void getOutputSpatialDimIndices(size_t &heightIndex,
+						size_t &widthIndex)
+	{
+		getInputSpatialDimIndices(heightIndex, widthIndex);
+	}
+
+	/**
+	  * @brief Detect dynamic input height and width, and if so fill in the requested
+	  * inference resolution in the input shape and in the dynamic output spatial dims
+	*/
+	void
+	applyRequestedSpatialDims(std::vector<std::vector<int64_t>> &inputDims,
+				  std::vector<std::vector<int64_t>> &outputDims)
+	{
+		size_t heightIndex, widthIndex;
+		getInputSpatialDimIndices(heightIndex, widthIndex);
+		dynamicSpatialDims = inputDims[0].size() > widthIndex &&
+				     inputDims[0][heightIndex] <= 0 &&
+				     inputDims[0][widthIndex] <= 0;
+		if (!dynamicSpatialDims || requestedWidth == 0 ||
+		    requestedHeight == 0) {
+			return;
+		}
+		inputDims[0][heightIndex] = requestedHeight;
+		inputDims[0][widthIndex] = requestedWidth;
+
+		getOutputSpatialDimIndices(heightIndex, widthIndex);
+		if (outputDims[0].size() > widthIndex) {
+			if (outputDims[0][heightIndex] <= 0) {
+				outputDims[0][heightIndex] = requestedHeight;
+			}
+			if (outputDims[0][widthIndex] <= 0) {
+				outputDims[0][widthIndex] = requestedWidth;
+			}
+		}
+	}
+
 	virtual void allocateTensorBuffers(
 		const std::vector<std::vector<int64_t>> &inputDims,
 		const std::vector<std::vector<int64_t>> &outputDims,
@@ -288,11 +369,48 @@ public:
 			       outputTensorValues[0].data());
 	}
 
+	/**
+	  * @brief Feed outputs back as inputs of the next frame, for models with
+	  * temporal (recurrent) state. Implementations may swap buffers and their
+	  * tensors instead of copying.
+	*/
 	virtual void assignOutputToInput(std::vector<std::vector<float>> &,
-					 std::vector<std::vector<float>> &)
+					 std::vector<std::vector<float>> &,
+					 std::vector<Ort::Value> &,
+					 std::vector<Ort::Value> &)
 	{
 	}
 
+	/**
+	  * @brief True if the model carries state from one frame to the next, so it must
+	  * see every frame whole
+	*/
+	virtual bool isRecurrent() { return false; }
+
+	/**
+	  * @brief True if the model runs at the resolution of the source frames rather
+	  * than at a fixed (or requested) network resolution
+	*/
+	virtual bool followsSourceResolution() { return false; }
+
+	/**
+	  * @brief True if the output holds parameters rather than an image, so it is
+	  * returned as [0,1] float instead of being quantized to 8 bits
+	*/
+	virtual bool keepsFloatOutput() { return false; }
+
+	/**
+	  * @brief Update the input and output shapes for a new source frame size
+	  *
+	  * @return true if the shapes changed and the tensor buffers must be reallocated
+	*/
+	virtual bool adaptToSourceSize(uint32_t, uint32_t,
+				       std::vector<std::vector<int64_t>> &,
+				       std::vector<std::vector<int64_t>> &)
+	{
+		return false;
+	}
+
 	virtual void runNetworkInference(
 		const std::unique_ptr<Ort::Session> &session,
 		const std::vector<Ort::AllocatedStringPtr> &inputNames,
@@ -338,9 +456,16 @@ public:
 
 	virtual void postprocessOutput(cv::Mat &output)
 	{
-		cv::Mat outputTransposed;
-		chw_to_hwc_32f(output, outputTransposed);
-		outputTransposed.copyTo(output);
+		chw_to_hwc_32f(output, postprocessScratch);
+		output = postprocessScratch;
+	}
+
+	virtual void getInputSpatialDimIndices(size_t &heightIndex,
+					       size_t &widthIndex)
+	{
+		// BCHW
+		heightIndex = 2;
+		widthIndex = 3;
 	}
 
 	virtual void
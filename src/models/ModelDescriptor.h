@@ -0,0 +1,50 @@
+#ifndef MODELDESCRIPTOR_H
+#define MODELDESCRIPTOR_H
+
+#include <opencv2/core.hpp>
+
+#include <string>
+
+enum class TensorLayout {
+	NHWC,
+	NCHW,
+	// No batch dimension
+	HWC,
+};
+
+/**
+  * @brief Declarative description of a model, one entry of data/models/models.json
+  *
+  * Image models with one input and one output are fully described here and run in
+  * a ModelPipeline. Models with extra inputs or recurrent state name a code-backed
+  * class instead, and only use the identification fields.
+*/
+struct ModelDescriptor {
+	// Model path relative to the plugin data, also the model_select setting value
+	std::string file;
+	// Locale key of the name shown in the model list
+	std::string name;
+	// "background" or "enhance"
+	std::string filter;
+	// Code-backed implementation ("rvm", "uretinex"), empty for a ModelPipeline
+	std::string modelClass;
+
+	// Input: the RGB frame in [0,255] is mapped to (x * scale - mean) / std
+	TensorLayout inputLayout = TensorLayout::NHWC;
+	double inputScale = 1.0 / 255.0;
+	cv::Scalar mean{0.0, 0.0, 0.0};
+	cv::Scalar std{1.0, 1.0, 1.0};
+
+	// Output: optionally one channel, min-max normalized, then x * scale + offset
+	TensorLayout outputLayout = TensorLayout::NHWC;
+	int outputChannel = -1;
+	bool outputMinMax = false;
+	double outputScale = 1.0;
+	double outputOffset = 0.0;
+	// The output height and width follow the input's (dynamic output dims)
+	bool outputSizeFromInput = false;
+	// The output holds Zero-DCE curve parameters rather than an image
+	bool outputIsCurves = false;
+};
+
+#endif /* MODELDESCRIPTOR_H */
@@ -0,0 +1,177 @@
+#ifndef MODELPIPELINE_H
+#define MODELPIPELINE_H
+
+#include "Model.h"
+#include "ModelDescriptor.h"
+
+/**
+  * @brief Pre and post-processing of a single image input / single output model,
+  * driven by its descriptor
+  *
+  * The tensor layouts are template parameters, so the layout handling is resolved
+  * at compile time and each instantiation only contains the steps it needs. The
+  * normalization constants come from the descriptor.
+*/
+template<TensorLayout InputLayout, TensorLayout OutputLayout>
+class ModelPipeline : public Model {
+public:
+	explicit ModelPipeline(const ModelDescriptor &descriptor_)
+		: descriptor(descriptor_)
+	{
+		// (x * scale - mean) / std = x * alpha + beta
+		for (int c = 0; c < 3; c++) {
+			alpha[c] = descriptor.inputScale / descriptor.std[c];
+			beta[c] = -descriptor.mean[c] / descriptor.std[c];
+		}
+		uniformNormalization = alpha[0] == alpha[1] &&
+				       alpha[1] == alpha[2] &&
+				       beta[0] == beta[1] && beta[1] == beta[2];
+	}
+	~ModelPipeline() {}
+
+	virtual bool
+	populateInputOutputShapes(const std::unique_ptr<Ort::Session> &session,
+				  std::vector<std::vector<int64_t>> &inputDims,
+				  std::vector<std::vector<int64_t>> &outputDims)
+	{
+		if (!Model::populateInputOutputShapes(session, inputDims,
+						      outputDims)) {
+			return false;
+		}
+
+		if (descriptor.outputSizeFromInput) {
+			size_t inHeight, inWidth, outHeight, outWidth;
+			getInputSpatialDimIndices(inHeight, inWidth);
+			getOutputSpatialDimIndices(outHeight, outWidth);
+			outputDims[0].at(outHeight) = inputDims[0].at(inHeight);
+			outputDims[0].at(outWidth) = inputDims[0].at(inWidth);
+		}
+		return true;
+	}
+
+	virtual void getInputSpatialDimIndices(size_t &heightIndex,
+					       size_t &widthIndex)
+	{
+		getSpatialDimIndices(InputLayout, heightIndex, widthIndex);
+	}
+
+	virtual void getOutputSpatialDimIndices(size_t &heightIndex,
+						size_t &widthIndex)
+	{
+		getSpatialDimIndices(OutputLayout, heightIndex, widthIndex);
+	}
+
+	virtual void
+	getNetworkInputSize(const std::vector<std::vector<int64_t>> &inputDims,
+			    uint32_t &inputWidth, uint32_t &inputHeight)
+	{
+		size_t heightIndex, widthIndex;
+		getSpatialDimIndices(InputLayout, heightIndex, widthIndex);
+		inputWidth = (uint32_t)inputDims[0][widthIndex];
+		inputHeight = (uint32_t)inputDims[0][heightIndex];
+	}
+
+	virtual void prepareInputToNetwork(cv::Mat &resizedImage,
+					   cv::Mat &preprocessedImage)
+	{
+		// In place, so the reused buffer doesn't reallocate
+		if (uniformNormalization) {
+			if (alpha[0] != 1.0 || beta[0] != 0.0) {
+				resizedImage.convertTo(resizedImage, -1,
+						       alpha[0], beta[0]);
+			}
+		} else {
+			cv::multiply(resizedImage, alpha, resizedImage);
+			cv::add(resizedImage, beta, resizedImage);
+		}
+		// Planar inputs are deinterleaved straight into the tensor
+		preprocessedImage = resizedImage;
+	}
+
+	virtual void
+	loadInputToTensor(const cv::Mat &preprocessedImage, uint32_t inputWidth,
+			  uint32_t inputHeight,
+			  std::vector<std::vector<float>> &inputTensorValues)
+	{
+		if (InputLayout == TensorLayout::NCHW) {
+			deinterleaveF32(preprocessedImage.ptr<float>(),
+					inputTensorValues[0].data(),
+					preprocessedImage.total(),
+					preprocessedImage.channels());
+		} else {
+			Model::loadInputToTensor(preprocessedImage, inputWidth,
+						 inputHeight,
+						 inputTensorValues);
+		}
+	}
+
+	virtual cv::Mat
+	getNetworkOutput(const std::vector<std::vector<int64_t>> &outputDims,
+			 std::vector<std::vector<float>> &outputTensorValues)
+	{
+		size_t heightIndex, widthIndex, channelIndex;
+		getSpatialDimIndices(OutputLayout, heightIndex, widthIndex);
+		channelIndex = OutputLayout == TensorLayout::NCHW
+				       ? 1
+				       : widthIndex + 1;
+		const int outputWidth = (int)outputDims[0].at(widthIndex);
+		const int outputHeight = (int)outputDims[0].at(heightIndex);
+		const int outputType = CV_MAKE_TYPE(
+			CV_32F, (int)outputDims[0].at(channelIndex));
+
+		return cv::Mat(outputHeight, outputWidth, outputType,
+			       outputTensorValues[0].data());
+	}
+
+	virtual bool keepsFloatOutput() { return descriptor.outputIsCurves; }
+
+	virtual void postprocessOutput(cv::Mat &output)
+	{
+		if (OutputLayout == TensorLayout::NCHW &&
+		    output.channels() > 1) {
+			chw_to_hwc_32f(output, postprocessScratch);
+			output = postprocessScratch;
+		}
+		if (descriptor.outputChannel >= 0 && output.channels() > 1) {
+			cv::extractChannel(output, channelScratch,
+					   descriptor.outputChannel);
+			output = channelScratch;
+		}
+		if (descriptor.outputMinMax) {
+			cv::normalize(output, output, 1.0, 0.0,
+				      cv::NORM_MINMAX);
+		}
+		if (descriptor.outputScale != 1.0 ||
+		    descriptor.outputOffset != 0.0) {
+			output.convertTo(output, -1, descriptor.outputScale,
+					 descriptor.outputOffset);
+		}
+	}
+
+private:
+	static void getSpatialDimIndices(TensorLayout layout,
+					 size_t &heightIndex, size_t &widthIndex)
+	{
+		switch (layout) {
+		case TensorLayout::NCHW:
+			heightIndex = 2;
+			widthIndex = 3;
+			break;
+		case TensorLayout::HWC:
+			heightIndex = 0;
+			widthIndex = 1;
+			break;
+		default:
+			heightIndex = 1;
+			widthIndex = 2;
+			break;
+		}
+	}
+
+	const ModelDescriptor descriptor;
+	cv::Scalar alpha;
+	cv::Scalar beta;
+	bool uniformNormalization;
+};
+
+#endif /* MODELPIPELINE_H */
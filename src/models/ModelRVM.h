@@ -58,30 +58,63 @@ public:
 			outputDims.push_back(outputTensorInfo.GetShape());
 		}
 
-		const int base_width = 320;
-		const int base_height = 192;
+		// RVM is fully convolutional, use the requested resolution if any
+		dynamicSpatialDims = true;
+		const int base_width =
+			(requestedWidth > 0) ? (int)requestedWidth : 320;
+		const int base_height =
+			(requestedHeight > 0) ? (int)requestedHeight : 192;
 
 		inputDims[0][0] = 1;
-		inputDims[0][2] = base_height;
-		inputDims[0][3] = base_width;
+		outputDims[0][0] = 1;
 		for (size_t i = 1; i < 5; i++) {
 			inputDims[i][0] = 1;
 			inputDims[i][1] = (i == 1)   ? 16
 					  : (i == 2) ? 20
 					  : (i == 3) ? 40
 						     : 64;
-			inputDims[i][2] = base_height / (2 << (i - 1));
-			inputDims[i][3] = base_width / (2 << (i - 1));
+			outputDims[i][0] = 1;
 		}
+		// Until the first frame arrives when following the source resolution
+		setSpatialDims(base_width, base_height, 1.0f, inputDims,
+			       outputDims);
+		return true;
+	}
 
-		outputDims[0][0] = 1;
-		outputDims[0][2] = base_height;
-		outputDims[0][3] = base_width;
-		for (size_t i = 1; i < 5; i++) {
-			outputDims[i][0] = 1;
-			outputDims[i][2] = base_height / (2 << (i - 1));
-			outputDims[i][3] = base_width / (2 << (i - 1));
+	virtual bool isRecurrent() { return true; }
+
+	virtual bool followsSourceResolution()
+	{
+		return downsampleRatio != 0.0f;
+	}
+
+	virtual bool
+	adaptToSourceSize(uint32_t sourceWidth, uint32_t sourceHeight,
+			  std::vector<std::vector<int64_t>> &inputDims,
+			  std::vector<std::vector<int64_t>> &outputDims)
+	{
+		if (!followsSourceResolution()) {
+			return false;
+		}
+		// Auto: keep the internal (encoder) resolution around 512px, as recommended
+		// for RVM
+		const float ratio =
+			(downsampleRatio > 0.0f)
+				? downsampleRatio
+				: std::min(1.0f,
+					   512.0f / (float)std::max(
+							    sourceWidth,
+							    sourceHeight));
+		if (inputDims[0][3] == (int64_t)sourceWidth &&
+		    inputDims[0][2] == (int64_t)sourceHeight &&
+		    ratio == activeDownsampleRatio) {
+			return false;
 		}
+		setSpatialDims((int)sourceWidth, (int)sourceHeight, ratio,
+			       inputDims, outputDims);
+		obs_log(LOG_INFO,
+			"RVM running at %ux%u with downsample ratio %.3f",
+			sourceWidth, sourceHeight, ratio);
 		return true;
 	}
 
@@ -91,17 +124,58 @@ public:
 	{
 		inputTensorValues[0].assign(preprocessedImage.begin<float>(),
 					    preprocessedImage.end<float>());
-		inputTensorValues[5][0] = 1.0f;
+		inputTensorValues[5][0] = activeDownsampleRatio;
 	}
 
 	virtual void
 	assignOutputToInput(std::vector<std::vector<float>> &outputTensorValues,
-			    std::vector<std::vector<float>> &inputTensorValues)
+			    std::vector<std::vector<float>> &inputTensorValues,
+			    std::vector<Ort::Value> &outputTensor,
+			    std::vector<Ort::Value> &inputTensor)
+	{
+		// Ping-pong the recurrent state (r1-r4): the outputs of this frame become
+		// the inputs of the next one, and the old inputs are overwritten next run.
+		// The tensors move along with their buffers, so no data is copied.
+		for (size_t i = 1; i < 5; i++) {
+			std::swap(inputTensorValues[i], outputTensorValues[i]);
+			std::swap(inputTensor[i], outputTensor[i]);
+		}
+	}
+
+	// downsample_ratio input of RVM, 0 to run at the network resolution (ratio 1)
+	// and a negative value to pick it from the source resolution
+	float downsampleRatio = 0.0f;
+
+private:
+	float activeDownsampleRatio = 1.0f;
+
+	/**
+	  * @brief Set the image and recurrent state shapes for a source size and ratio
+	  *
+	  * The encoder runs on the source downsampled by the ratio, and the recurrent
+	  * states are at 1/2, 1/4, 1/8 and 1/16 of that (rounded up, as strided convs do).
+	*/
+	void setSpatialDims(int width, int height, float ratio,
+			    std::vector<std::vector<int64_t>> &inputDims,
+			    std::vector<std::vector<int64_t>> &outputDims)
 	{
+		activeDownsampleRatio = ratio;
+
+		inputDims[0][2] = height;
+		inputDims[0][3] = width;
+		outputDims[0][2] = height;
+		outputDims[0][3] = width;
+
+		int64_t stateHeight = (int64_t)std::floor(height * ratio);
+		int64_t stateWidth = (int64_t)std::floor(width * ratio);
 		for (size_t i = 1; i < 5; i++) {
-			inputTensorValues[i].assign(
-				outputTensorValues[i].begin(),
-				outputTensorValues[i].end());
+			stateHeight = (stateHeight + 1) / 2;
+			stateWidth = (stateWidth + 1) / 2;
+			inputDims[i][2] = stateHeight;
+			inputDims[i][3] = stateWidth;
+			outputDims[i][1] = inputDims[i][1];
+			outputDims[i][2] = stateHeight;
+			outputDims[i][3] = stateWidth;
 		}
 	}
 };
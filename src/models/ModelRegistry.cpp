@@ -0,0 +1,199 @@
+#include "ModelRegistry.h"
+
+#include <cstring>
+
+#include "plugin-support.h"
+#include "ModelPipeline.h"
+#include "ModelRVM.h"
+#include "ModelURetinex.h"
+
+static TensorLayout parseTensorLayout(const char *layout, const char *file)
+{
+	if (strcmp(layout, "nchw") == 0) {
+		return TensorLayout::NCHW;
+	}
+	if (strcmp(layout, "hwc") == 0) {
+		return TensorLayout::HWC;
+	}
+	if (strcmp(layout, "nhwc") != 0) {
+		obs_log(LOG_WARNING,
+			"Unknown tensor layout '%s' for %s, assuming nhwc",
+			layout, file);
+	}
+	return TensorLayout::NHWC;
+}
+
+/**
+  * @brief Read a per-channel constant, an object with "r", "g" and "b" members
+*/
+static cv::Scalar getRGB(obs_data_t *data, const char *name,
+			 double defaultValue)
+{
+	obs_data_t *rgb = obs_data_get_obj(data, name);
+	if (!rgb) {
+		return cv::Scalar::all(defaultValue);
+	}
+	obs_data_set_default_double(rgb, "r", defaultValue);
+	obs_data_set_default_double(rgb, "g", defaultValue);
+	obs_data_set_default_double(rgb, "b", defaultValue);
+	const cv::Scalar value(obs_data_get_double(rgb, "r"),
+			       obs_data_get_double(rgb, "g"),
+			       obs_data_get_double(rgb, "b"));
+	obs_data_release(rgb);
+	return value;
+}
+
+static ModelDescriptor parseModelDescriptor(obs_data_t *entry)
+{
+	ModelDescriptor descriptor;
+	descriptor.file = obs_data_get_string(entry, "file");
+	descriptor.name = obs_data_get_string(entry, "name");
+	descriptor.filter = obs_data_get_string(entry, "filter");
+	descriptor.modelClass = obs_data_get_string(entry, "class");
+
+	obs_data_t *input = obs_data_get_obj(entry, "input");
+	if (input) {
+		obs_data_set_default_string(input, "layout", "nhwc");
+		obs_data_set_default_double(input, "scale",
+					    descriptor.inputScale);
+		descriptor.inputLayout = parseTensorLayout(
+			obs_data_get_string(input, "layout"),
+			descriptor.file.c_str());
+		descriptor.inputScale = obs_data_get_double(input, "scale");
+		descriptor.mean = getRGB(input, "mean", 0.0);
+		descriptor.std = getRGB(input, "std", 1.0);
+		obs_data_release(input);
+	}
+
+	obs_data_t *output = obs_data_get_obj(entry, "output");
+	if (output) {
+		obs_data_set_default_string(output, "layout", "nhwc");
+		obs_data_set_default_int(output, "channel", -1);
+		obs_data_set_default_double(output, "scale", 1.0);
+		descriptor.outputLayout = parseTensorLayout(
+			obs_data_get_string(output, "layout"),
+			descriptor.file.c_str());
+		descriptor.outputChannel =
+			(int)obs_data_get_int(output, "channel");
+		descriptor.outputMinMax =
+			strcmp(obs_data_get_string(output, "normalize"),
+			       "minmax") == 0;
+		descriptor.outputScale = obs_data_get_double(output, "scale");
+		descriptor.outputOffset =
+			obs_data_get_double(output, "offset");
+		descriptor.outputSizeFromInput =
+			strcmp(obs_data_get_string(output, "size"), "input") ==
+			0;
+		descriptor.outputIsCurves =
+			strcmp(obs_data_get_string(output, "kind"), "curves") ==
+			0;
+		obs_data_release(output);
+	}
+	return descriptor;
+}
+
+static std::vector<ModelDescriptor> loadModelDescriptors()
+{
+	std::vector<ModelDescriptor> descriptors;
+
+	char *registryPath = obs_module_file(MODEL_REGISTRY_PATH);
+	if (registryPath == nullptr) {
+		obs_log(LOG_ERROR, "Unable to find the model registry %s",
+			MODEL_REGISTRY_PATH);
+		return descriptors;
+	}
+	obs_data_t *registry = obs_data_create_from_json_file(registryPath);
+	bfree(registryPath);
+	if (!registry) {
+		obs_log(LOG_ERROR, "Failed to parse the model registry %s",
+			MODEL_REGISTRY_PATH);
+		return descriptors;
+	}
+
+	obs_data_array_t *models = obs_data_get_array(registry, "models");
+	for (size_t i = 0; i < obs_data_array_count(models); i++) {
+		obs_data_t *entry = obs_data_array_item(models, i);
+		ModelDescriptor descriptor = parseModelDescriptor(entry);
+		obs_data_release(entry);
+
+		if (descriptor.file.empty() || descriptor.filter.empty()) {
+			obs_log(LOG_WARNING,
+				"Skipping model registry entry %d without a file or filter",
+				(int)i);
+			continue;
+		}
+		descriptors.push_back(descriptor);
+	}
+	obs_data_array_release(models);
+	obs_data_release(registry);
+
+	obs_log(LOG_INFO, "Loaded %d models from %s", (int)descriptors.size(),
+		MODEL_REGISTRY_PATH);
+	return descriptors;
+}
+
+const std::vector<ModelDescriptor> &getModelDescriptors()
+{
+	static const std::vector<ModelDescriptor> descriptors =
+		loadModelDescriptors();
+	return descriptors;
+}
+
+const ModelDescriptor *findModelDescriptor(const std::string &modelSelection)
+{
+	for (const ModelDescriptor &descriptor : getModelDescriptors()) {
+		if (descriptor.file == modelSelection) {
+			return &descriptor;
+		}
+	}
+	return nullptr;
+}
+
+template<TensorLayout InputLayout>
+static Model *createModelPipeline(const ModelDescriptor &descriptor)
+{
+	switch (descriptor.outputLayout) {
+	case TensorLayout::NCHW:
+		return new ModelPipeline<InputLayout, TensorLayout::NCHW>(
+			descriptor);
+	case TensorLayout::HWC:
+		return new ModelPipeline<InputLayout, TensorLayout::HWC>(
+			descriptor);
+	default:
+		return new ModelPipeline<InputLayout, TensorLayout::NHWC>(
+			descriptor);
+	}
+}
+
+std::unique_ptr<Model> createModel(const ModelDescriptor &descriptor)
+{
+	if (descriptor.modelClass == "rvm") {
+		return std::unique_ptr<Model>(new ModelRVM);
+	}
+	if (descriptor.modelClass == "uretinex") {
+		return std::unique_ptr<Model>(new ModelURetinex);
+	}
+	if (!descriptor.modelClass.empty()) {
+		obs_log(LOG_ERROR, "Unknown model class '%s' for %s",
+			descriptor.modelClass.c_str(), descriptor.file.c_str());
+		return nullptr;
+	}
+
+	if (descriptor.inputLayout == TensorLayout::NCHW) {
+		return std::unique_ptr<Model>(
+			createModelPipeline<TensorLayout::NCHW>(descriptor));
+	}
+	return std::unique_ptr<Model>(
+		createModelPipeline<TensorLayout::NHWC>(descriptor));
+}
+
+void addModelsToList(obs_property_t *list, const char *filter)
+{
+	for (const ModelDescriptor &descriptor : getModelDescriptors()) {
+		if (descriptor.filter == filter) {
+			obs_property_list_add_string(
+				list, obs_module_text(descriptor.name.c_str()),
+				descriptor.file.c_str());
+		}
+	}
+}
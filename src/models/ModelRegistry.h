@@ -0,0 +1,42 @@
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+
+#include <obs-module.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+#include "ModelDescriptor.h"
+
+const char *const MODEL_REGISTRY_PATH = "models/models.json";
+
+const char *const MODEL_FILTER_BACKGROUND = "background";
+const char *const MODEL_FILTER_ENHANCE = "enhance";
+
+/**
+  * @brief The model descriptors of data/models/models.json, read on first use
+*/
+const std::vector<ModelDescriptor> &getModelDescriptors();
+
+/**
+  * @brief Find the descriptor of a model by its file (the model_select value)
+  *
+  * @return The descriptor, or nullptr if the model is not in the registry
+*/
+const ModelDescriptor *findModelDescriptor(const std::string &modelSelection);
+
+/**
+  * @brief Instantiate the model described by a descriptor
+  *
+  * @return The model, or nullptr if the descriptor names an unknown class
+*/
+std::unique_ptr<Model> createModel(const ModelDescriptor &descriptor);
+
+/**
+  * @brief Add the registered models of a filter to a model selection list
+*/
+void addModelsToList(obs_property_t *list, const char *filter);
+
+#endif /* MODELREGISTRY_H */
@@ -0,0 +1,81 @@
+#include "filter-stats.h"
+
+#include <cstdio>
+
+// Weight of the newest inference time in its moving average
+static const double INFERENCE_MS_SMOOTHING = 0.1;
+// Length of the window the rates are counted over
+static const std::chrono::milliseconds STATS_WINDOW(1000);
+
+/**
+  * @brief Close the current window if it is over, its counts become the rates
+*/
+static void rollWindow(FilterStats &stats)
+{
+	const auto now = std::chrono::steady_clock::now();
+	const auto elapsed = now - stats.windowStart;
+	if (elapsed < STATS_WINDOW) {
+		return;
+	}
+	const double seconds =
+		std::chrono::duration<double>(elapsed).count();
+	// A window far in the past means nothing was counted in between
+	const bool stale = elapsed > 2 * STATS_WINDOW;
+	stats.maskFps = stale ? 0.0 : (double)stats.windowMasks / seconds;
+	for (int i = 0; i < SKIP_REASON_COUNT; i++) {
+		stats.skips[i] = stale ? 0 : stats.windowSkips[i];
+		stats.windowSkips[i] = 0;
+	}
+	stats.windowMasks = 0;
+	stats.windowStart = now;
+}
+
+void recordInference(FilterStats &stats, double ms,
+		     const std::string &provider)
+{
+	stats.inferenceMs = stats.inferenceMs > 0.0
+				    ? stats.inferenceMs +
+					      INFERENCE_MS_SMOOTHING *
+						      (ms - stats.inferenceMs)
+				    : ms;
+	stats.provider = provider;
+}
+
+void recordMask(FilterStats &stats)
+{
+	rollWindow(stats);
+	stats.windowMasks++;
+}
+
+void recordSkip(FilterStats &stats, SkipReason reason)
+{
+	rollWindow(stats);
+	stats.windowSkips[reason]++;
+}
+
+std::string formatFilterStats(const FilterStats &stats)
+{
+	static const char *const skipNames[SKIP_REASON_COUNT] = {
+		"similar", "interval", "no frame", "no session", "tuning",
+		"static edge"};
+
+	char line[128];
+	snprintf(line, sizeof(line), "Inference: %.1f ms on %s\n",
+		 stats.inferenceMs,
+		 stats.provider.empty() ? "-" : stats.provider.c_str());
+	std::string text = line;
+	snprintf(line, sizeof(line), "Masks: %.1f/s", stats.maskFps);
+	text += line;
+
+	std::string skips;
+	for (int i = 0; i < SKIP_REASON_COUNT; i++) {
+		if (stats.skips[i] == 0) {
+			continue;
+		}
+		snprintf(line, sizeof(line), "%s%s %u", skips.empty() ? "" : ", ",
+			 skipNames[i], stats.skips[i]);
+		skips += line;
+	}
+	text += "\nSkipped/s: " + (skips.empty() ? std::string("none") : skips);
+	return text;
+}
@@ -0,0 +1,73 @@
+#ifndef FILTER_STATS_H
+#define FILTER_STATS_H
+
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+  * @brief Why a tick produced no new mask
+*/
+enum SkipReason {
+	// The frame was almost the same as the previous one
+	SKIP_REASON_SIMILAR_FRAME = 0,
+	// Between two "Calculate every X frame" masks
+	SKIP_REASON_MASK_INTERVAL,
+	// No frame was read back, or the render thread was writing it
+	SKIP_REASON_NO_FRAME,
+	// The session is still being built
+	SKIP_REASON_NO_SESSION,
+	// The auto-tuner is measuring
+	SKIP_REASON_AUTO_TUNING,
+	// The frame only changed away from the mask edge
+	SKIP_REASON_STATIC_EDGE,
+	SKIP_REASON_COUNT,
+};
+
+/**
+  * @brief Performance counters of a filter, updated by the tick and read by the
+  * properties and the stats overlay
+*/
+struct FilterStats {
+	// Moving average of the inference time
+	double inferenceMs = 0.0;
+	// Provider of the last inference
+	std::string provider;
+
+	// Counts of the current window
+	std::chrono::steady_clock::time_point windowStart;
+	uint32_t windowMasks = 0;
+	uint32_t windowSkips[SKIP_REASON_COUNT] = {};
+
+	// Rates of the last complete window
+	double maskFps = 0.0;
+	uint32_t skips[SKIP_REASON_COUNT] = {};
+
+	// Tile grid of the last change map, 255 where a tile changed, empty if none
+	cv::Mat changedTiles;
+};
+
+/**
+  * @brief Count a model inference and its duration
+*/
+void recordInference(FilterStats &stats, double ms,
+		     const std::string &provider);
+
+/**
+  * @brief Count a new mask
+*/
+void recordMask(FilterStats &stats);
+
+/**
+  * @brief Count a tick that produced no new mask
+*/
+void recordSkip(FilterStats &stats, SkipReason reason);
+
+/**
+  * @brief Format the counters as lines of text, for the properties and the overlay
+*/
+std::string formatFilterStats(const FilterStats &stats);
+
+#endif /* FILTER_STATS_H */
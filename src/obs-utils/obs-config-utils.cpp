@@ -17,14 +17,15 @@ void create_config_folder()
 	bfree(config_folder_path);
 }
 
-int getConfig(config_t **config)
+int getConfig(config_t **config,
+	      enum config_open_type openType = CONFIG_OPEN_EXISTING)
 {
 	create_config_folder(); // ensure the config folder exists
 
 	// Get the config file
 	char *config_file_path = obs_module_config_path("config.ini");
 
-	int ret = config_open(config, config_file_path, CONFIG_OPEN_EXISTING);
+	int ret = config_open(config, config_file_path, openType);
 	if (ret != CONFIG_SUCCESS) {
 		obs_log(LOG_INFO, "Failed to open config file %s",
 			config_file_path);
@@ -65,3 +66,66 @@ int setFlagInConfig(const char *name, const bool value)
 
 	return OBS_BGREMOVAL_CONFIG_SUCCESS;
 }
+
+int getStringFromConfig(const char *name, std::string &returnValue,
+			const char *defaultValue)
+{
+	config_t *config;
+	if (getConfig(&config) != OBS_BGREMOVAL_CONFIG_SUCCESS) {
+		returnValue = defaultValue;
+		return OBS_BGREMOVAL_CONFIG_FAIL;
+	}
+
+	const char *value = config_get_string(config, "config", name);
+	returnValue = value ? value : "";
+	config_close(config);
+
+	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+}
+
+int setStringInConfig(const char *name, const std::string &value)
+{
+	config_t *config;
+	// Created if missing, unlike for reading
+	if (getConfig(&config, CONFIG_OPEN_ALWAYS) !=
+	    OBS_BGREMOVAL_CONFIG_SUCCESS) {
+		return OBS_BGREMOVAL_CONFIG_FAIL;
+	}
+
+	config_set_string(config, "config", name, value.c_str());
+	config_save(config);
+	config_close(config);
+
+	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+}
+
+int getIntFromConfig(const char *name, int64_t *returnValue,
+		     int64_t defaultValue)
+{
+	config_t *config;
+	if (getConfig(&config) != OBS_BGREMOVAL_CONFIG_SUCCESS) {
+		*returnValue = defaultValue;
+		return OBS_BGREMOVAL_CONFIG_FAIL;
+	}
+
+	*returnValue = config_get_int(config, "config", name);
+	config_close(config);
+
+	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+}
+
+int setIntInConfig(const char *name, int64_t value)
+{
+	config_t *config;
+	// Created if missing, unlike for reading
+	if (getConfig(&config, CONFIG_OPEN_ALWAYS) !=
+	    OBS_BGREMOVAL_CONFIG_SUCCESS) {
+		return OBS_BGREMOVAL_CONFIG_FAIL;
+	}
+
+	config_set_int(config, "config", name, value);
+	config_save(config);
+	config_close(config);
+
+	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+}
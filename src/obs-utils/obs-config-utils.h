@@ -1,6 +1,9 @@
 #ifndef OBS_CONFIG_UTILS_H
 #define OBS_CONFIG_UTILS_H
 
+#include <cstdint>
+#include <string>
+
 enum {
 	OBS_BGREMOVAL_CONFIG_SUCCESS = 0,
 	OBS_BGREMOVAL_CONFIG_FAIL = 1,
@@ -27,4 +30,48 @@ int getFlagFromConfig(const char *name, bool *returnValue, bool defaultValue);
  */
 int setFlagInConfig(const char *name, const bool value);
 
+/**
+ * Get a string from the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param returnValue The value of the config item, empty if it is not set.
+ * @param defaultValue The value if the config file can't be opened.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config file was read,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getStringFromConfig(const char *name, std::string &returnValue,
+			const char *defaultValue);
+
+/**
+ * Set a string in the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config file was written,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setStringInConfig(const char *name, const std::string &value);
+
+/**
+ * Get an integer from the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param returnValue The value of the config item, 0 if it is not set.
+ * @param defaultValue The value if the config file can't be opened.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config file was read,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getIntFromConfig(const char *name, int64_t *returnValue,
+		     int64_t defaultValue);
+
+/**
+ * Set an integer in the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config file was written,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setIntInConfig(const char *name, int64_t value);
+
 #endif /* OBS_CONFIG_UTILS_H */
@@ -1,30 +1,47 @@
 #include "obs-utils.h"
 
 #include <obs-module.h>
+#include <util/platform.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <string>
+
+// Frames of an async target that stopped arriving in filter_video for this long
+// are read back from the render again
+static const uint64_t ASYNC_FRAME_TIMEOUT_NS = 500000000;
 
 /**
-  * @brief Get RGBA from the stage surface
+  * @brief Get the size of the filter's target
+*/
+static bool getTargetSize(filter_data *tf, uint32_t &width, uint32_t &height)
+{
+	obs_source_t *target = obs_filter_get_target(tf->source);
+	if (!target) {
+		return false;
+	}
+	width = obs_source_get_base_width(target);
+	height = obs_source_get_base_height(target);
+	return width != 0 && height != 0;
+}
+
+/**
+  * @brief Render the filter's target into tf->texrender
   *
   * @param tf  The filter data
-  * @param width  The width of the stage surface (output)
-  * @param height  The height of the stage surface (output)
+  * @param width  The width of the target (output)
+  * @param height  The height of the target (output)
   * @return true  if successful
-  * @return false if unsuccessful
 */
-bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
+static bool renderTargetTexture(filter_data *tf, uint32_t &width,
+				uint32_t &height)
 {
-
 	if (!obs_source_enabled(tf->source)) {
 		return false;
 	}
 
 	obs_source_t *target = obs_filter_get_target(tf->source);
-	if (!target) {
-		return false;
-	}
-	width = obs_source_get_base_width(target);
-	height = obs_source_get_base_height(target);
-	if (width == 0 || height == 0) {
+	if (!getTargetSize(tf, width, height)) {
 		return false;
 	}
 	gs_texrender_reset(tf->texrender);
@@ -41,6 +58,23 @@ bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
 	obs_source_video_render(target);
 	gs_blend_state_pop();
 	gs_texrender_end(tf->texrender);
+	return true;
+}
+
+/**
+  * @brief Get RGBA from the stage surface
+  *
+  * @param tf  The filter data
+  * @param width  The width of the stage surface (output)
+  * @param height  The height of the stage surface (output)
+  * @return true  if successful
+  * @return false if unsuccessful
+*/
+bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
+{
+	if (!renderTargetTexture(tf, width, height)) {
+		return false;
+	}
 
 	if (tf->stagesurface) {
 		uint32_t stagesurf_width =
@@ -65,9 +99,218 @@ bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
 	}
 	{
 		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
-		tf->inputBGRA =
-			cv::Mat(height, width, CV_8UC4, video_data, linesize);
+		// Copy out of the mapped surface, which is only valid until unmapped.
+		// The buffer is reused while the source size doesn't change.
+		cv::Mat(height, width, CV_8UC4, video_data, linesize)
+			.copyTo(tf->inputBGRA);
+		tf->inputYUV.release();
+		tf->inputFrameTime = obs_get_video_frame_time();
 	}
 	gs_stagesurface_unmap(tf->stagesurface);
 	return true;
 }
+
+/**
+  * @brief View the planes of a YUV async frame, without copying
+  *
+  * @param view  The frame's planes and color matrix
+  * @return false if the frame isn't in a supported YUV format
+*/
+static bool yuvImageFromFrame(const struct obs_source_frame *frame,
+			      YuvImage &view)
+{
+	const int width = (int)frame->width;
+	const int height = (int)frame->height;
+	if (width % 2 != 0 || height % 2 != 0) {
+		return false;
+	}
+	view.release();
+	switch (frame->format) {
+	case VIDEO_FORMAT_NV12:
+		view.format = YUV_FORMAT_NV12;
+		view.planes[0] = cv::Mat(height, width, CV_8UC1, frame->data[0],
+					 frame->linesize[0]);
+		view.planes[1] = cv::Mat(height / 2, width / 2, CV_8UC2,
+					 frame->data[1], frame->linesize[1]);
+		break;
+	case VIDEO_FORMAT_I420:
+		view.format = YUV_FORMAT_I420;
+		view.planes[0] = cv::Mat(height, width, CV_8UC1, frame->data[0],
+					 frame->linesize[0]);
+		for (int plane = 1; plane < 3; plane++) {
+			view.planes[plane] =
+				cv::Mat(height / 2, width / 2, CV_8UC1,
+					frame->data[plane],
+					frame->linesize[plane]);
+		}
+		break;
+	case VIDEO_FORMAT_YUY2:
+	case VIDEO_FORMAT_UYVY:
+		view.format = frame->format == VIDEO_FORMAT_YUY2
+				      ? YUV_FORMAT_YUY2
+				      : YUV_FORMAT_UYVY;
+		view.planes[0] = cv::Mat(height, width, CV_8UC2, frame->data[0],
+					 frame->linesize[0]);
+		break;
+	default:
+		return false;
+	}
+	// The rows of the frame's matrix, which also hold its range
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			view.colorMatrix[i][j] = frame->color_matrix[4 * i + j];
+		}
+	}
+	return true;
+}
+
+/**
+  * @brief Convert an async RGB frame to BGRA
+  *
+  * @return false if the frame isn't in a supported RGB format
+*/
+static bool rgbFrameToBGRA(const struct obs_source_frame *frame,
+			   cv::Mat &imageBGRA)
+{
+	const int width = (int)frame->width;
+	const int height = (int)frame->height;
+	switch (frame->format) {
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		cv::Mat(height, width, CV_8UC4, frame->data[0],
+			frame->linesize[0])
+			.copyTo(imageBGRA);
+		return true;
+	case VIDEO_FORMAT_RGBA:
+		cv::cvtColor(cv::Mat(height, width, CV_8UC4, frame->data[0],
+				     frame->linesize[0]),
+			     imageBGRA, cv::COLOR_RGBA2BGRA);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+  * @brief Take the input frame of an async target from its CPU memory, for the
+  * filter_video callback
+  *
+  * Only the first effect filter on the source sees the frame it renders. Frames in
+  * unsupported formats are left to the render and readback path.
+  *
+  * @param tf  The filter data
+  * @param frame  The frame, passed through unchanged
+*/
+struct obs_source_frame *filterAsyncVideo(filter_data *tf,
+					  struct obs_source_frame *frame)
+{
+	if (tf->isDisabled || !obs_source_enabled(tf->source)) {
+		return frame;
+	}
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	if (!parent || obs_filter_get_target(tf->source) != parent) {
+		return frame;
+	}
+	YuvImage frameYUV;
+	const bool isYUV = yuvImageFromFrame(frame, frameYUV);
+	{
+		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
+		if (isYUV && tf->acceptsYuvInput) {
+			// The filter preprocesses the planes itself
+			frameYUV.copyTo(tf->inputYUV);
+			tf->inputBGRA.release();
+			if (frame->flip) {
+				tf->inputYUV.flipVertical();
+			}
+		} else {
+			if (isYUV) {
+				yuvToBGRA(frameYUV, tf->asyncFrameScratch,
+					  tf->inputBGRA);
+			} else if (!rgbFrameToBGRA(frame, tf->inputBGRA)) {
+				return frame;
+			}
+			tf->inputYUV.release();
+			if (frame->flip) {
+				cv::flip(tf->inputBGRA, tf->inputBGRA, 0);
+			}
+		}
+		tf->inputFrameTime = obs_get_video_frame_time();
+	}
+	tf->asyncFrameTime = os_gettime_ns();
+	return frame;
+}
+
+/**
+  * @brief Get the filter's input frame into tf->inputBGRA, or tf->inputYUV for the
+  * filters that accept it, for the tick
+  *
+  * Frames of async targets arrive in filterAsyncVideo, then only the size is read
+  * and the target is rendered to tf->texrender if needsTexture, without the
+  * readback. Other targets go through getRGBAFromStageSurface.
+  *
+  * @param tf  The filter data
+  * @param width  The width of the target (output)
+  * @param height  The height of the target (output)
+  * @param needsTexture  The render uses the target in tf->texrender
+  * @return true  if successful
+*/
+bool getInputFrame(filter_data *tf, uint32_t &width, uint32_t &height,
+		   bool needsTexture)
+{
+	const bool asyncInput =
+		tf->asyncFrameTime != 0 &&
+		os_gettime_ns() - tf->asyncFrameTime < ASYNC_FRAME_TIMEOUT_NS;
+	if (!asyncInput) {
+		return getRGBAFromStageSurface(tf, width, height);
+	}
+	if (needsTexture) {
+		return renderTargetTexture(tf, width, height);
+	}
+	return obs_source_enabled(tf->source) &&
+	       getTargetSize(tf, width, height);
+}
+
+/**
+  * @brief Show the time to first output of the current session, if known
+  *
+  * @param props  The filter properties to add the info text to
+  * @param tf  The filter data
+*/
+void addTimeToFirstOutputInfo(obs_properties_t *props, filter_data *tf)
+{
+	double timeToFirstOutputMs;
+	{
+		std::lock_guard<std::mutex> lock(tf->modelMutex);
+		timeToFirstOutputMs = tf->timeToFirstOutputMs;
+	}
+	if (timeToFirstOutputMs <= 0.0) {
+		return;
+	}
+	char value[32];
+	snprintf(value, sizeof(value), " %.0f ms", timeToFirstOutputMs);
+	const std::string info =
+		std::string(obs_module_text("TimeToFirstOutput")) + value;
+	obs_properties_add_text(props, "time_to_first_output", info.c_str(),
+				OBS_TEXT_INFO);
+}
+
+/**
+  * @brief Add the performance counters to the filter properties, once a mask was
+  * computed
+  *
+  * @param props  The filter properties to add the info text to
+  * @param tf  The filter data
+*/
+void addFilterStatsInfo(obs_properties_t *props, filter_data *tf)
+{
+	std::string stats;
+	{
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		if (tf->stats.provider.empty()) {
+			return;
+		}
+		stats = formatFilterStats(tf->stats);
+	}
+	obs_properties_add_text(props, "filter_stats", stats.c_str(),
+				OBS_TEXT_INFO);
+}
@@ -6,4 +6,14 @@
 bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width,
 			     uint32_t &height);
 
+struct obs_source_frame *filterAsyncVideo(filter_data *tf,
+					  struct obs_source_frame *frame);
+
+bool getInputFrame(filter_data *tf, uint32_t &width, uint32_t &height,
+		   bool needsTexture);
+
+void addTimeToFirstOutputInfo(obs_properties_t *props, filter_data *tf);
+
+void addFilterStatsInfo(obs_properties_t *props, filter_data *tf);
+
 #endif /* OBS_UTILS_H */
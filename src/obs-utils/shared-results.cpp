@@ -0,0 +1,156 @@
+#include "shared-results.h"
+
+#include <obs-module.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "ort-utils/ort-session-utils.h"
+
+struct SharedResult {
+	const filter_data *publisher = nullptr;
+	uint64_t frameTime = 0;
+	cv::Size inputSize;
+	cv::Mat output;
+};
+
+// (parent source, model and settings) -> latest result computed from the parent's
+// own output
+typedef std::pair<const obs_source_t *, std::string> SharedResultKey;
+
+static std::mutex sharedResultsMutex;
+static std::map<SharedResultKey, SharedResult> sharedResults;
+
+// Background removal filters keep the frame geometry and the person, a mask or depth
+// map of the frame above them is valid for the filters below
+static const char *const MASK_FILTER_ID = "background_removal";
+
+/**
+  * @brief What a filter reads, compared to the output of its parent source
+*/
+enum SharedInput {
+	// The parent's own output: no enabled video filter is above this one
+	SHARED_INPUT_PARENT = 0,
+	// Only background removal filters are above this mask consumer
+	SHARED_INPUT_BEHIND_MASKS,
+	// Another video filter changed it
+	SHARED_INPUT_OTHER,
+};
+
+static SharedInput getSharedInput(const filter_data *tf, obs_source_t *parent)
+{
+	const bool masksPassThrough =
+		strcmp(obs_source_get_unversioned_id(tf->source),
+		       MASK_FILTER_ID) == 0;
+	SharedInput input = SHARED_INPUT_PARENT;
+	obs_source_t *upstream = obs_filter_get_target(tf->source);
+	for (; upstream && upstream != parent;
+	     upstream = obs_filter_get_target(upstream)) {
+		if (!obs_source_enabled(upstream) ||
+		    !(obs_source_get_output_flags(upstream) & OBS_SOURCE_VIDEO)) {
+			continue;
+		}
+		if (!masksPassThrough ||
+		    strcmp(obs_source_get_unversioned_id(upstream),
+			   MASK_FILTER_ID) != 0) {
+			return SHARED_INPUT_OTHER;
+		}
+		input = SHARED_INPUT_BEHIND_MASKS;
+	}
+	return upstream == parent ? input : SHARED_INPUT_OTHER;
+}
+
+/**
+  * @brief Shared by the BGRA and the YUV frames, a result computed from one serves the
+  * other when filters of the same source get different inputs
+*/
+template<typename Image>
+static bool runSharedInference(filter_data *tf, ORTModelData *session,
+			       const Image &image, const cv::Size &inputSize,
+			       const std::string &settingsKey, cv::Mat &output)
+{
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	// A consumer of a recurrent model's result wouldn't advance its own state
+	if (!parent || tf->frameTime == 0 || !session->model ||
+	    session->model->isRecurrent()) {
+		return runFilterModelInference(session, image, output);
+	}
+	const SharedInput input = getSharedInput(tf, parent);
+	if (input == SHARED_INPUT_OTHER) {
+		return runFilterModelInference(session, image, output);
+	}
+
+	const SharedResultKey key(parent,
+				  session->modelSelection + "|" + settingsKey);
+	{
+		std::lock_guard<std::mutex> lock(sharedResultsMutex);
+		auto it = sharedResults.find(key);
+		if (it != sharedResults.end() &&
+		    it->second.frameTime == tf->frameTime &&
+		    it->second.inputSize == inputSize) {
+			it->second.output.copyTo(output);
+			return true;
+		}
+	}
+
+	if (!runFilterModelInference(session, image, output)) {
+		return false;
+	}
+	if (input != SHARED_INPUT_PARENT) {
+		// Computed from a frame the filters above changed, only used here
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(sharedResultsMutex);
+	SharedResult &result = sharedResults[key];
+	result.publisher = tf;
+	result.frameTime = tf->frameTime;
+	result.inputSize = inputSize;
+	// The entry's buffer is reused while the output size doesn't change
+	output.copyTo(result.output);
+	return true;
+}
+
+bool runSharedModelInference(filter_data *tf, const cv::Mat &imageBGRA,
+			     const std::string &settingsKey, cv::Mat &output)
+{
+	return runSharedInference(tf, tf, imageBGRA, imageBGRA.size(),
+				  settingsKey, output);
+}
+
+bool runSharedModelInference(filter_data *tf, const YuvImage &imageYUV,
+			     const std::string &settingsKey, cv::Mat &output)
+{
+	return runSharedInference(tf, tf, imageYUV, imageYUV.size(),
+				  settingsKey, output);
+}
+
+bool runSharedModelInference(filter_data *tf, ORTModelData *session,
+			     const cv::Mat &imageBGRA,
+			     const std::string &settingsKey, cv::Mat &output)
+{
+	return runSharedInference(tf, session, imageBGRA, imageBGRA.size(),
+				  settingsKey, output);
+}
+
+bool runSharedModelInference(filter_data *tf, ORTModelData *session,
+			     const YuvImage &imageYUV,
+			     const std::string &settingsKey, cv::Mat &output)
+{
+	return runSharedInference(tf, session, imageYUV, imageYUV.size(),
+				  settingsKey, output);
+}
+
+void releaseSharedResults(const filter_data *tf)
+{
+	std::lock_guard<std::mutex> lock(sharedResultsMutex);
+	for (auto it = sharedResults.begin(); it != sharedResults.end();) {
+		if (it->second.publisher == tf) {
+			it = sharedResults.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
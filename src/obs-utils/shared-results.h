@@ -0,0 +1,56 @@
+#ifndef SHARED_RESULTS_H
+#define SHARED_RESULTS_H
+
+#include <string>
+
+#include "FilterData.h"
+
+/**
+  * @brief Run the filter's model on a frame, or reuse the result another filter already
+  * computed for the same frame of the same source
+  *
+  * Results are shared per parent source, keyed by the model, the settings that change
+  * the model output and the render frame the input was read back in. Only results
+  * computed from the parent's own output are published, by filters with no enabled
+  * video filter above them. Background removal filters only change the background
+  * around the person, so the background removal filters below them use the published
+  * masks and depth maps too. Other filters further down the chain read a changed
+  * input and run their own model. Recurrent models (Robust Video Matting) are not
+  * shared: a consumer would never advance its own recurrent state.
+  *
+  * The consumers still threshold and post-process the shared output with their own
+  * settings. Must be called with tf->modelMutex held, like runFilterModelInference.
+  *
+  * @param tf The filter data, tf->frameTime identifies the frame
+  * @param imageBGRA The frame
+  * @param settingsKey The settings besides the model that affect its output
+  * @param output The model output, CV_8U
+  * @return true if output holds a result
+*/
+bool runSharedModelInference(filter_data *tf, const cv::Mat &imageBGRA,
+			     const std::string &settingsKey, cv::Mat &output);
+
+/**
+  * @brief Same, for a camera frame in its YUV layout
+*/
+bool runSharedModelInference(filter_data *tf, const YuvImage &imageYUV,
+			     const std::string &settingsKey, cv::Mat &output);
+
+/**
+  * @brief Same, with another session of the filter, e.g. its depth model. Called with
+  * the lock of that session held.
+*/
+bool runSharedModelInference(filter_data *tf, ORTModelData *session,
+			     const cv::Mat &imageBGRA,
+			     const std::string &settingsKey, cv::Mat &output);
+
+bool runSharedModelInference(filter_data *tf, ORTModelData *session,
+			     const YuvImage &imageYUV,
+			     const std::string &settingsKey, cv::Mat &output);
+
+/**
+  * @brief Drop the results published by a filter, when it is destroyed
+*/
+void releaseSharedResults(const filter_data *tf);
+
+#endif /* SHARED_RESULTS_H */
@@ -2,10 +2,43 @@
 #define ORTMODELDATA_H
 
 #include <onnxruntime_cxx_api.h>
+#include <obs-module.h>
+
+#include <chrono>
+
+#include "models/Model.h"
+#include "ort-model-cache.h"
 
 struct ORTModelData {
+	// Requested execution provider, the first one tried in the fallback chain
+	std::string useGPU;
+	// Execution provider the session was actually created with
+	std::string activeProvider;
+	uint32_t numThreads = 0;
+	std::string modelSelection;
+	std::unique_ptr<Model> model;
+	// Short side of the inference resolution for models with dynamic spatial dims,
+	// 0 keeps the model's own resolution
+	uint32_t inferenceShortSide = 0;
+	// Dummy inferences to run before the session is published
+	uint32_t warmupRuns = 0;
+	// Size of the source frames when the session was requested, 0 if unknown. Models
+	// that run at the source resolution are warmed up at it.
+	uint32_t sourceWidth = 0;
+	uint32_t sourceHeight = 0;
+	// The filter builds a new session in the background when the source size changes,
+	// this one keeps running at its size meanwhile instead of reshaping in place
+	bool rebuildsForSourceSize = false;
+
+	// Time-to-first-output tracking: from the build request to the first inference result
+	std::chrono::steady_clock::time_point requestTime;
+	bool firstOutputPending = false;
+	double timeToFirstOutputMs = 0.0;
+
+	// Must be declared before the session, which may reference the mapped model
+	std::unique_ptr<MappedModelFile> mappedModel;
 	std::unique_ptr<Ort::Session> session;
-	std::unique_ptr<Ort::Env> env;
+	std::shared_ptr<Ort::Env> env;
 	std::vector<Ort::AllocatedStringPtr> inputNames;
 	std::vector<Ort::AllocatedStringPtr> outputNames;
 	std::vector<Ort::Value> inputTensor;
@@ -14,6 +47,54 @@ struct ORTModelData {
 	std::vector<std::vector<int64_t>> outputDims;
 	std::vector<std::vector<float>> outputTensorValues;
 	std::vector<std::vector<float>> inputTensorValues;
+
+	// Pre-processing buffers, reused across frames. They belong to the instance
+	// running inference and are not exchanged by swapSession.
+	cv::Mat resizedImageBGRA;
+	cv::Mat resizedImageRGB;
+	cv::Mat resizedImage;
+	cv::Mat preprocessedImage;
+
+#if _WIN32
+	std::wstring modelFilepath;
+#else
+	std::string modelFilepath;
+#endif
+
+	/**
+	  * @brief Exchange the model, session and all of its buffers with another instance
+	  *
+	  * Only pointers and vector headers move, so the tensors keep pointing at their
+	  * (now swapped) buffers. Used to publish a session that was built in the background.
+	*/
+	void swapSession(ORTModelData &other)
+	{
+		std::swap(useGPU, other.useGPU);
+		std::swap(activeProvider, other.activeProvider);
+		std::swap(numThreads, other.numThreads);
+		std::swap(modelSelection, other.modelSelection);
+		std::swap(model, other.model);
+		std::swap(inferenceShortSide, other.inferenceShortSide);
+		std::swap(warmupRuns, other.warmupRuns);
+		std::swap(sourceWidth, other.sourceWidth);
+		std::swap(sourceHeight, other.sourceHeight);
+		std::swap(rebuildsForSourceSize, other.rebuildsForSourceSize);
+		std::swap(requestTime, other.requestTime);
+		std::swap(firstOutputPending, other.firstOutputPending);
+		std::swap(timeToFirstOutputMs, other.timeToFirstOutputMs);
+		std::swap(mappedModel, other.mappedModel);
+		std::swap(session, other.session);
+		std::swap(env, other.env);
+		std::swap(inputNames, other.inputNames);
+		std::swap(outputNames, other.outputNames);
+		std::swap(inputTensor, other.inputTensor);
+		std::swap(outputTensor, other.outputTensor);
+		std::swap(inputDims, other.inputDims);
+		std::swap(outputDims, other.outputDims);
+		std::swap(outputTensorValues, other.outputTensorValues);
+		std::swap(inputTensorValues, other.inputTensorValues);
+		std::swap(modelFilepath, other.modelFilepath);
+	}
 };
 
 #endif /* ORTMODELDATA_H */
@@ -0,0 +1,239 @@
+#include "ort-auto-tune.h"
+
+#include <obs-module.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "ort-session-utils.h"
+#include "plugin-support.h"
+#include "cpu-utils/cpu-budget.h"
+#include "obs-utils/obs-config-utils.h"
+
+// Time spent measuring each candidate, after its warm-up
+static const double AUTOTUNE_CANDIDATE_MS = 1500.0;
+static const size_t AUTOTUNE_MIN_RUNS = 5;
+static const size_t AUTOTUNE_MAX_RUNS = 200;
+static const uint32_t AUTOTUNE_WARMUP_RUNS = 2;
+
+/**
+  * @brief Build a candidate session and measure its median inference time
+  *
+  * @param inputDims Receives the input dims of the built session
+*/
+static bool benchmarkCandidate(const cv::Mat &frameBGRA,
+			       std::unique_ptr<ORTModelData> staged,
+			       const std::function<bool()> &isCancelled,
+			       double &medianMs, std::vector<int64_t> &inputDims)
+{
+	if (!staged) {
+		return false;
+	}
+	try {
+		if (createOrtSession(staged.get()) !=
+		    OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+			return false;
+		}
+		if (staged->activeProvider != staged->useGPU) {
+			// Fell back to another provider, which is measured on its own
+			return false;
+		}
+		if (!warmUpOrtSession(staged.get(), AUTOTUNE_WARMUP_RUNS,
+				      isCancelled)) {
+			return false;
+		}
+
+		std::vector<double> runsMs;
+		cv::Mat output;
+		const auto start = std::chrono::steady_clock::now();
+		double elapsedMs = 0.0;
+		while (runsMs.size() < AUTOTUNE_MIN_RUNS ||
+		       (elapsedMs < AUTOTUNE_CANDIDATE_MS &&
+			runsMs.size() < AUTOTUNE_MAX_RUNS)) {
+			if (isCancelled()) {
+				return false;
+			}
+			const auto runStart = std::chrono::steady_clock::now();
+			if (!runFilterModelInference(staged.get(), frameBGRA,
+						     output)) {
+				return false;
+			}
+			const auto runEnd = std::chrono::steady_clock::now();
+			runsMs.push_back(std::chrono::duration<double, std::milli>(
+						 runEnd - runStart)
+						 .count());
+			elapsedMs = std::chrono::duration<double, std::milli>(
+					    runEnd - start)
+					    .count();
+		}
+		std::nth_element(runsMs.begin(),
+				 runsMs.begin() + runsMs.size() / 2,
+				 runsMs.end());
+		medianMs = runsMs[runsMs.size() / 2];
+		inputDims = staged->inputDims.at(0);
+	} catch (const std::exception &e) {
+		obs_log(LOG_WARNING, "Auto-tune candidate %s failed: %s",
+			staged->useGPU.c_str(), e.what());
+		return false;
+	}
+	return true;
+}
+
+bool autoTuneSession(const cv::Mat &frameBGRA, const StageSessionFn &stage,
+		     const std::vector<std::string> &providers,
+		     double frameBudgetMs,
+		     const std::function<bool()> &isCancelled, TuneConfig &best)
+{
+	std::vector<uint32_t> threadCandidates = {0};
+	for (uint32_t threads : {1u, 2u, 4u}) {
+		if (threads <= getUsableCpuCount()) {
+			threadCandidates.push_back(threads);
+		}
+	}
+
+	// Providers and threads, at the model's own resolution
+	bool found = false;
+	std::vector<int64_t> defaultDims;
+	for (const std::string &provider : providers) {
+		for (uint32_t threads : threadCandidates) {
+			if (!isCpuExecutionProvider(provider) && threads > 0) {
+				// The thread count only matters to the CPU providers
+				break;
+			}
+			double ms;
+			std::vector<int64_t> dims;
+			if (!benchmarkCandidate(frameBGRA,
+						stage(provider, threads, 0),
+						isCancelled, ms, dims)) {
+				if (isCancelled()) {
+					return false;
+				}
+				continue;
+			}
+			obs_log(LOG_INFO,
+				"Auto-tune: %s, %u threads: %.1f ms",
+				provider.c_str(), threads, ms);
+			if (!found || ms < best.inferenceMs) {
+				best.useGPU = provider;
+				best.numThreads = threads;
+				best.inferenceShortSide = 0;
+				best.inferenceMs = ms;
+				defaultDims = dims;
+				found = true;
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	// Inference resolutions, if the own resolution doesn't fit the budget
+	if (best.inferenceMs > frameBudgetMs) {
+		TuneConfig fastest = best;
+		TuneConfig largestFitting;
+		for (uint32_t shortSide : {144u, 192u, 256u, 384u, 512u}) {
+			double ms;
+			std::vector<int64_t> dims;
+			if (!benchmarkCandidate(
+				    frameBGRA,
+				    stage(best.useGPU, best.numThreads,
+					  shortSide),
+				    isCancelled, ms, dims)) {
+				if (isCancelled()) {
+					return false;
+				}
+				continue;
+			}
+			if (dims == defaultDims) {
+				// Fixed input dims, the resolution has no effect
+				break;
+			}
+			obs_log(LOG_INFO, "Auto-tune: %s, %u threads, %up: %.1f ms",
+				best.useGPU.c_str(), best.numThreads, shortSide,
+				ms);
+			if (ms < fastest.inferenceMs) {
+				fastest.inferenceShortSide = shortSide;
+				fastest.inferenceMs = ms;
+			}
+			if (ms <= frameBudgetMs) {
+				largestFitting = best;
+				largestFitting.inferenceShortSide = shortSide;
+				largestFitting.inferenceMs = ms;
+			}
+		}
+		best = largestFitting.useGPU.empty() ? fastest : largestFitting;
+	}
+
+	best.maskEveryXFrames = std::max(
+		1u, (uint32_t)std::ceil(best.inferenceMs / frameBudgetMs));
+	obs_log(LOG_INFO,
+		"Auto-tune picked %s, %u threads, resolution %u, mask every %u frames (%.1f ms, budget %.1f ms)",
+		best.useGPU.c_str(), best.numThreads, best.inferenceShortSide,
+		best.maskEveryXFrames, best.inferenceMs, frameBudgetMs);
+	return true;
+}
+
+/**
+  * @brief Config key of a tuned value, per machine and model
+*/
+static std::string getTuneConfigKey(const std::string &model,
+				    const char *field)
+{
+	char hostname[256] = "";
+#ifdef _WIN32
+	DWORD size = sizeof(hostname);
+	GetComputerNameA(hostname, &size);
+#else
+	gethostname(hostname, sizeof(hostname) - 1);
+#endif
+	// The CPU count tells a resized VM or container apart
+	std::string key = std::string("autotune_") + hostname + "_" +
+			  std::to_string(getUsableCpuCount()) + "_" + model +
+			  "_" + field;
+	std::replace_if(
+		key.begin(), key.end(),
+		[](char c) { return !isalnum((unsigned char)c) && c != '_'; },
+		'_');
+	return key;
+}
+
+void saveTunedConfig(const std::string &model, const TuneConfig &config)
+{
+	setStringInConfig(getTuneConfigKey(model, "useGPU").c_str(),
+			  config.useGPU);
+	setIntInConfig(getTuneConfigKey(model, "numThreads").c_str(),
+		       config.numThreads);
+	setIntInConfig(getTuneConfigKey(model, "inference_resolution").c_str(),
+		       config.inferenceShortSide);
+	setIntInConfig(getTuneConfigKey(model, "mask_every_x_frames").c_str(),
+		       config.maskEveryXFrames);
+}
+
+bool loadTunedConfig(const std::string &model, TuneConfig &config)
+{
+	if (getStringFromConfig(getTuneConfigKey(model, "useGPU").c_str(),
+				config.useGPU,
+				"") != OBS_BGREMOVAL_CONFIG_SUCCESS ||
+	    config.useGPU.empty()) {
+		return false;
+	}
+	int64_t value;
+	getIntFromConfig(getTuneConfigKey(model, "numThreads").c_str(), &value,
+			 0);
+	config.numThreads = (uint32_t)value;
+	getIntFromConfig(
+		getTuneConfigKey(model, "inference_resolution").c_str(), &value,
+		0);
+	config.inferenceShortSide = (uint32_t)value;
+	getIntFromConfig(getTuneConfigKey(model, "mask_every_x_frames").c_str(),
+			 &value, 1);
+	config.maskEveryXFrames = std::max(1u, (uint32_t)value);
+	return true;
+}
@@ -0,0 +1,69 @@
+#ifndef ORT_AUTO_TUNE_H
+#define ORT_AUTO_TUNE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ORTModelData.h"
+
+/**
+  * @brief A session configuration picked by the auto-tuner
+*/
+struct TuneConfig {
+	std::string useGPU;
+	uint32_t numThreads = 0;
+	// 0 keeps the model's own resolution
+	uint32_t inferenceShortSide = 0;
+	uint32_t maskEveryXFrames = 1;
+	// Median inference time of the configuration
+	double inferenceMs = 0.0;
+};
+
+/**
+  * @brief Stage an unbuilt session of the model being tuned, with a candidate
+  * provider, thread count and inference resolution
+*/
+typedef std::function<std::unique_ptr<ORTModelData>(
+	const std::string &useGPU, uint32_t numThreads,
+	uint32_t inferenceShortSide)>
+	StageSessionFn;
+
+/**
+  * @brief Benchmark session configurations on a real frame and pick the best one
+  *
+  * First every provider and thread count runs at the model's own resolution, then
+  * the fastest of them at the inference resolutions, if the model takes any. The
+  * model's own resolution is kept if it fits the frame budget, otherwise the highest
+  * resolution that does. If nothing fits, the fastest configuration is picked and
+  * the mask is computed every few frames instead.
+  *
+  * @param frameBGRA The frame to run the candidates on, at the source resolution
+  * @param stage Creates the staged sessions of the candidates
+  * @param providers The execution providers to try
+  * @param frameBudgetMs Time an inference may take per frame
+  * @param isCancelled Checked between runs
+  * @param best The picked configuration
+  * @return false if cancelled or no configuration ran
+*/
+bool autoTuneSession(const cv::Mat &frameBGRA, const StageSessionFn &stage,
+		     const std::vector<std::string> &providers,
+		     double frameBudgetMs,
+		     const std::function<bool()> &isCancelled,
+		     TuneConfig &best);
+
+/**
+  * @brief Store the tuned configuration of a model for this machine in the module
+  * config
+*/
+void saveTunedConfig(const std::string &model, const TuneConfig &config);
+
+/**
+  * @brief Read the tuned configuration of a model for this machine
+  *
+  * @return false if the model wasn't tuned on this machine
+*/
+bool loadTunedConfig(const std::string &model, TuneConfig &config);
+
+#endif /* ORT_AUTO_TUNE_H */
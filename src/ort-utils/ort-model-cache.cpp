@@ -0,0 +1,298 @@
+#include "ort-model-cache.h"
+
+#include <obs-module.h>
+#include <util/platform.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cinttypes>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "plugin-support.h"
+
+/**
+  * @brief Id of this process, to name its temporary files
+*/
+static unsigned long getProcessId()
+{
+#ifdef _WIN32
+	return (unsigned long)GetCurrentProcessId();
+#else
+	return (unsigned long)getpid();
+#endif
+}
+
+MappedModelFile::~MappedModelFile()
+{
+#if _WIN32
+	if (data != nullptr) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr && fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+	}
+#else
+	if (data != nullptr) {
+		munmap(const_cast<void *>(data), size);
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+#endif
+}
+
+static std::unique_ptr<MappedModelFile>
+mapModelFile(const std::filesystem::path &path)
+{
+	std::unique_ptr<MappedModelFile> mapped(new MappedModelFile);
+#if _WIN32
+	mapped->fileHandle = CreateFileW(path.c_str(), GENERIC_READ,
+					 FILE_SHARE_READ, nullptr,
+					 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+					 nullptr);
+	if (mapped->fileHandle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mapped->fileHandle, &fileSize) ||
+	    fileSize.QuadPart == 0) {
+		return nullptr;
+	}
+	mapped->size = (size_t)fileSize.QuadPart;
+	mapped->mappingHandle = CreateFileMappingW(
+		mapped->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapped->mappingHandle == nullptr) {
+		return nullptr;
+	}
+	mapped->data = MapViewOfFile(mapped->mappingHandle, FILE_MAP_READ, 0,
+				     0, 0);
+#else
+	mapped->fd = open(path.c_str(), O_RDONLY);
+	if (mapped->fd < 0) {
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(mapped->fd, &st) != 0 || st.st_size == 0) {
+		return nullptr;
+	}
+	mapped->size = (size_t)st.st_size;
+	void *data = mmap(nullptr, mapped->size, PROT_READ, MAP_PRIVATE,
+			  mapped->fd, 0);
+	mapped->data = (data == MAP_FAILED) ? nullptr : data;
+#endif
+	if (mapped->data == nullptr) {
+		return nullptr;
+	}
+	return mapped;
+}
+
+static uint64_t fnv1a(const char *data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (uint8_t)data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static const uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+/**
+  * @brief Hash the content of a model file
+  *
+  * The hash is memoized per path, size and modification time so that
+  * re-creating a session (e.g. on a settings change) does not re-read the file.
+*/
+static uint64_t hashModelFile(const std::filesystem::path &path)
+{
+	static std::mutex memoMutex;
+	static std::map<std::string, uint64_t> memo;
+
+	std::error_code ec;
+	const auto fileSize = std::filesystem::file_size(path, ec);
+	if (ec) {
+		return 0;
+	}
+	const auto mtime = std::filesystem::last_write_time(path, ec);
+	if (ec) {
+		return 0;
+	}
+	const std::string memoKey =
+		path.u8string() + "|" + std::to_string(fileSize) + "|" +
+		std::to_string(mtime.time_since_epoch().count());
+
+	{
+		std::lock_guard<std::mutex> lock(memoMutex);
+		auto it = memo.find(memoKey);
+		if (it != memo.end()) {
+			return it->second;
+		}
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return 0;
+	}
+	uint64_t hash = FNV1A_OFFSET_BASIS;
+	std::vector<char> buffer(1 << 16);
+	while (file) {
+		file.read(buffer.data(), (std::streamsize)buffer.size());
+		hash = fnv1a(buffer.data(), (size_t)file.gcount(), hash);
+	}
+
+	std::lock_guard<std::mutex> lock(memoMutex);
+	memo[memoKey] = hash;
+	return hash;
+}
+
+/**
+  * @brief Get the path of the cached ORT format model
+  *
+  * The cache lives in <module config>/model-cache/<plugin version>/ so that a plugin
+  * update (which may ship a different ORT) never picks up stale files.
+  * The file name is keyed by the model content hash and the cache key (EP, options,
+  * ORT version).
+*/
+static std::filesystem::path
+getCachedModelPath(const std::filesystem::path &modelFilepath,
+		   const std::string &cacheKey)
+{
+	const uint64_t modelHash = hashModelFile(modelFilepath);
+	if (modelHash == 0) {
+		return std::filesystem::path();
+	}
+
+	const std::string fullKey = cacheKey + "|ort=" +
+				    OrtGetApiBase()->GetVersionString();
+	const uint64_t keyHash = fnv1a(fullKey.c_str(), fullKey.size(),
+				       FNV1A_OFFSET_BASIS);
+
+	const std::string cacheSubdir =
+		std::string("model-cache/") + PLUGIN_VERSION;
+	char *cacheDir_rawPtr = obs_module_config_path(cacheSubdir.c_str());
+	if (cacheDir_rawPtr == nullptr) {
+		return std::filesystem::path();
+	}
+	if (os_mkdirs(cacheDir_rawPtr) == MKDIR_ERROR) {
+		obs_log(LOG_WARNING, "Failed to create model cache folder %s",
+			cacheDir_rawPtr);
+		bfree(cacheDir_rawPtr);
+		return std::filesystem::path();
+	}
+	std::filesystem::path cacheDir =
+		std::filesystem::u8path(cacheDir_rawPtr);
+	bfree(cacheDir_rawPtr);
+
+	char fileName[256];
+	snprintf(fileName, sizeof(fileName),
+		 "%s-%016" PRIx64 "-%016" PRIx64 ".ort",
+		 modelFilepath.stem().u8string().c_str(), modelHash, keyHash);
+
+	return cacheDir / fileName;
+}
+
+Ort::Session *createSessionWithModelCache(
+	const Ort::Env &env,
+#if _WIN32
+	const std::wstring &modelFilepath,
+#else
+	const std::string &modelFilepath,
+#endif
+	const Ort::SessionOptions &sessionOptions, const std::string &cacheKey,
+	std::unique_ptr<MappedModelFile> &mappedModel, bool &warmStart)
+{
+	warmStart = false;
+	mappedModel.reset();
+
+	std::filesystem::path cachedModelPath;
+	if (!cacheKey.empty()) {
+		cachedModelPath = getCachedModelPath(modelFilepath, cacheKey);
+	}
+
+	if (cachedModelPath.empty()) {
+		return new Ort::Session(env, modelFilepath.c_str(),
+					sessionOptions);
+	}
+
+	std::error_code ec;
+	if (std::filesystem::exists(cachedModelPath, ec)) {
+		std::unique_ptr<MappedModelFile> mapped =
+			mapModelFile(cachedModelPath);
+		if (mapped) {
+			// The cached graph is already optimized, and ORT may point
+			// straight into the mapping instead of copying the model and initializers.
+			Ort::SessionOptions warmOptions = sessionOptions.Clone();
+			warmOptions.SetGraphOptimizationLevel(
+				GraphOptimizationLevel::ORT_DISABLE_ALL);
+			warmOptions.AddConfigEntry(
+				"session.use_ort_model_bytes_directly", "1");
+			warmOptions.AddConfigEntry(
+				"session.use_ort_model_bytes_for_initializers",
+				"1");
+			try {
+				Ort::Session *session = new Ort::Session(
+					env, mapped->data, mapped->size,
+					warmOptions);
+				mappedModel = std::move(mapped);
+				warmStart = true;
+				return session;
+			} catch (const Ort::Exception &e) {
+				obs_log(LOG_WARNING,
+					"Failed to load cached model %s, rebuilding: %s",
+					cachedModelPath.u8string().c_str(),
+					e.what());
+			}
+		}
+		std::filesystem::remove(cachedModelPath, ec);
+	}
+
+	// Cold start: optimize the original model and serialize the result.
+	// Write to a temporary file first so a crash never leaves a truncated cache entry.
+	// The session builders, the depth builder and the auto-tuner may build the same
+	// model at once, each writes its own file.
+	std::filesystem::path tmpPath = cachedModelPath;
+	tmpPath += "." + std::to_string(getProcessId()) + "-" +
+		   std::to_string(std::hash<std::thread::id>()(
+			   std::this_thread::get_id())) +
+		   ".tmp";
+
+	Ort::SessionOptions coldOptions = sessionOptions.Clone();
+	coldOptions.SetOptimizedModelFilePath(tmpPath.c_str());
+	coldOptions.AddConfigEntry("session.save_model_format", "ORT");
+
+	Ort::Session *session = nullptr;
+	try {
+		session = new Ort::Session(env, modelFilepath.c_str(),
+					   coldOptions);
+	} catch (...) {
+		std::filesystem::remove(tmpPath, ec);
+		throw;
+	}
+
+	std::filesystem::rename(tmpPath, cachedModelPath, ec);
+	if (ec) {
+		obs_log(LOG_WARNING, "Failed to store optimized model %s: %s",
+			cachedModelPath.u8string().c_str(),
+			ec.message().c_str());
+		std::filesystem::remove(tmpPath, ec);
+	} else {
+		obs_log(LOG_INFO, "Stored optimized model in cache %s",
+			cachedModelPath.u8string().c_str());
+	}
+	return session;
+}
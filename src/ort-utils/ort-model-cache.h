@@ -0,0 +1,58 @@
+#ifndef ORT_MODEL_CACHE_H
+#define ORT_MODEL_CACHE_H
+
+#include <onnxruntime_cxx_api.h>
+
+#include <memory>
+#include <string>
+
+/**
+  * @brief Read-only memory mapping of a file on disk
+  *
+  * Used to hand a cached ORT format model to ONNXRuntime without copying it.
+  * The mapping must outlive the Ort::Session that was created from it.
+*/
+struct MappedModelFile {
+	const void *data = nullptr;
+	size_t size = 0;
+#if _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+
+	MappedModelFile() = default;
+	MappedModelFile(const MappedModelFile &) = delete;
+	MappedModelFile &operator=(const MappedModelFile &) = delete;
+	~MappedModelFile();
+};
+
+/**
+  * @brief Create an ORT session, going through the optimized model cache
+  *
+  * On a cache hit the session is created from a memory mapping of the cached
+  * ORT format model (no parsing of the .onnx, no graph optimization).
+  * On a miss the session is created from the original model and the optimized
+  * graph is serialized to the cache for the next load.
+  *
+  * @param env The ORT environment
+  * @param modelFilepath Path to the original .onnx model
+  * @param sessionOptions Fully configured session options (EP, threads, etc.)
+  * @param cacheKey Anything besides the model content that affects the optimized graph.
+  * An empty key disables the cache.
+  * @param mappedModel Receives the mapping backing the session on a warm start
+  * @param warmStart Set to true if the session was created from the cache
+  * @return The new session. Throws Ort::Exception on failure.
+*/
+Ort::Session *createSessionWithModelCache(
+	const Ort::Env &env,
+#if _WIN32
+	const std::wstring &modelFilepath,
+#else
+	const std::string &modelFilepath,
+#endif
+	const Ort::SessionOptions &sessionOptions, const std::string &cacheKey,
+	std::unique_ptr<MappedModelFile> &mappedModel, bool &warmStart);
+
+#endif /* ORT_MODEL_CACHE_H */
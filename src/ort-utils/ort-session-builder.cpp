@@ -0,0 +1,96 @@
+#include "ort-session-builder.h"
+
+#include <obs-module.h>
+
+#include "ort-session-utils.h"
+#include "plugin-support.h"
+#include "cpu-utils/thread-placement.h"
+
+OrtSessionBuilder::OrtSessionBuilder(PublishCallback publish_)
+	: publish(publish_)
+{
+	thread = std::thread(&OrtSessionBuilder::run, this);
+}
+
+OrtSessionBuilder::~OrtSessionBuilder()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		pending.reset();
+	}
+	condition.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void OrtSessionBuilder::request(std::unique_ptr<ORTModelData> staged)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pending) {
+			obs_log(LOG_INFO,
+				"Dropping pending session build for %s, superseded by %s",
+				pending->modelSelection.c_str(),
+				staged->modelSelection.c_str());
+		}
+		pending = std::move(staged);
+		generation++;
+	}
+	condition.notify_one();
+}
+
+bool OrtSessionBuilder::isSuperseded(uint64_t buildGeneration)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stopping || buildGeneration != generation;
+}
+
+void OrtSessionBuilder::run()
+{
+	applyThreadPlacement();
+	for (;;) {
+		std::unique_ptr<ORTModelData> staged;
+		uint64_t buildGeneration;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock,
+				       [this] { return stopping || pending; });
+			if (stopping) {
+				return;
+			}
+			staged = std::move(pending);
+			buildGeneration = generation;
+		}
+
+		ORTModelData *session = staged.get();
+		const std::function<bool()> isCancelled = [this, buildGeneration] {
+			return isSuperseded(buildGeneration);
+		};
+		const int result = createOrtSession(
+			session,
+			[session, &isCancelled] {
+				return warmUpOrtSession(session,
+							session->warmupRuns,
+							isCancelled);
+			},
+			isCancelled);
+
+		if (isSuperseded(buildGeneration)) {
+			obs_log(LOG_INFO,
+				"Discarding session for %s, a newer one was requested",
+				staged->modelSelection.c_str());
+			continue;
+		}
+
+		if (result != OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+			staged.reset();
+		} else {
+			staged->firstOutputPending = true;
+		}
+		publish(staged, result);
+		// Whatever the callback left in staged (i.e. the previous session) is released
+		// here, off the render and UI threads.
+	}
+}
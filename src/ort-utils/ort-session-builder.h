@@ -0,0 +1,61 @@
+#ifndef ORT_SESSION_BUILDER_H
+#define ORT_SESSION_BUILDER_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ORTModelData.h"
+
+/**
+  * @brief Builds ORT sessions on a background thread
+  *
+  * A filter hands over a staged ORTModelData (model object, device, threads) and keeps
+  * serving frames with its current session. Once the new session is ready the publish
+  * callback is invoked on the builder thread, where the filter swaps it in.
+  *
+  * Requests are coalesced: only the newest pending request is built. ORT cannot abort a
+  * session that is being constructed, so a build that gets superseded while running is
+  * finished but discarded instead of published.
+*/
+class OrtSessionBuilder {
+public:
+	/**
+	  * @param data The built session data, or nullptr if the build failed
+	  * @param result An OBS_BGREMOVAL_ORT_SESSION_* code
+	*/
+	typedef std::function<void(std::unique_ptr<ORTModelData> &data,
+				   int result)>
+		PublishCallback;
+
+	explicit OrtSessionBuilder(PublishCallback publish);
+	~OrtSessionBuilder();
+
+	OrtSessionBuilder(const OrtSessionBuilder &) = delete;
+	OrtSessionBuilder &operator=(const OrtSessionBuilder &) = delete;
+
+	/**
+	  * @brief Queue a session build, superseding any build that is pending or running
+	*/
+	void request(std::unique_ptr<ORTModelData> staged);
+
+	/**
+	  * @brief True if the build with the given generation is no longer the newest request
+	*/
+	bool isSuperseded(uint64_t generation);
+
+private:
+	void run();
+
+	PublishCallback publish;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::unique_ptr<ORTModelData> pending;
+	uint64_t generation = 0;
+	bool stopping = false;
+};
+
+#endif /* ORT_SESSION_BUILDER_H */
@@ -1,6 +1,13 @@
 #include <onnxruntime_cxx_api.h>
 #include <cpu_provider_factory.h>
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
 
 #if defined(__APPLE__)
 #include <coreml_provider_factory.h>
@@ -15,26 +22,265 @@
 #include <obs-module.h>
 
 #include "ort-session-utils.h"
+#include "ort-model-cache.h"
 #include "consts.h"
 #include "plugin-support.h"
+#include "cpu-utils/cpu-budget.h"
+#include "cpu-utils/thread-placement.h"
+#include "obs-utils/obs-config-utils.h"
+
+/**
+  * @brief Whether idle ORT pool threads may spin-wait, the ort_allow_spinning flag of
+  * the plugin config. Off by default: spinning burns the CPU budget that OBS needs.
+*/
+static bool isOrtSpinningAllowed()
+{
+	static const bool allowed = [] {
+		bool value = false;
+		getFlagFromConfig("ort_allow_spinning", &value, false);
+		return value;
+	}();
+	return allowed;
+}
 
-int createOrtSession(filter_data *tf)
+/**
+  * @brief ORT pool thread started by the plugin, so it can be placed on the
+  * configured CPUs and priority before it runs the ORT worker loop
+*/
+struct OrtPoolThread {
+	std::thread thread;
+};
+
+static OrtCustomThreadHandle createOrtPoolThread(void *options,
+						 OrtThreadWorkerFn workerFn,
+						 void *workerParam)
 {
-	if (tf->model.get() == nullptr) {
-		obs_log(LOG_ERROR, "Model object is not initialized");
-		return OBS_BGREMOVAL_ORT_SESSION_ERROR_INVALID_MODEL;
+	UNUSED_PARAMETER(options);
+	OrtPoolThread *poolThread = new OrtPoolThread;
+	poolThread->thread = std::thread([workerFn, workerParam] {
+		applyThreadPlacement();
+		workerFn(workerParam);
+	});
+	return reinterpret_cast<OrtCustomThreadHandle>(poolThread);
+}
+
+static void joinOrtPoolThread(OrtCustomThreadHandle handle)
+{
+	OrtPoolThread *poolThread = reinterpret_cast<OrtPoolThread *>(
+		const_cast<OrtCustomHandleType *>(handle));
+	poolThread->thread.join();
+	delete poolThread;
+}
+
+std::shared_ptr<Ort::Env> getSharedOrtEnv()
+{
+	static std::mutex envMutex;
+	static std::weak_ptr<Ort::Env> sharedEnv;
+
+	std::lock_guard<std::mutex> lock(envMutex);
+	std::shared_ptr<Ort::Env> env = sharedEnv.lock();
+	if (env) {
+		return env;
 	}
 
+	const uint32_t budget = getCpuBudget();
+	Ort::ThreadingOptions threadingOptions;
+	threadingOptions.SetGlobalIntraOpNumThreads((int)budget);
+	threadingOptions.SetGlobalInterOpNumThreads(1);
+	threadingOptions.SetGlobalSpinControl(isOrtSpinningAllowed() ? 1 : 0);
+	if (!getThreadPlacement().isDefault()) {
+		threadingOptions.SetGlobalCustomCreateThreadFn(
+			createOrtPoolThread);
+		threadingOptions.SetGlobalCustomJoinThreadFn(joinOrtPoolThread);
+	}
+	env = std::make_shared<Ort::Env>(threadingOptions,
+					 OrtLoggingLevel::ORT_LOGGING_LEVEL_ERROR,
+					 "obs-backgroundremoval");
+	sharedEnv = env;
+
+	// Pre- and post-processing run between inferences, on the same budget
+	cv::setNumThreads((int)budget);
+
+	obs_log(LOG_INFO,
+		"Created the ORT environment: %u shared threads, spinning %s",
+		budget, isOrtSpinningAllowed() ? "on" : "off");
+	return env;
+}
+
+std::vector<std::string>
+getExecutionProviderFallbackChain(const std::string &useGPU)
+{
+	std::vector<std::string> chain;
+	for (std::string provider = useGPU; !provider.empty();
+	     provider = getNextExecutionProvider(provider)) {
+		chain.push_back(provider);
+	}
+	return chain;
+}
+
+std::string getNextExecutionProvider(const std::string &provider)
+{
+	if (provider == USEGPU_CPU) {
+		return "";
+	}
+	if (provider == USEGPU_TENSORRT) {
+		// TensorRT needs CUDA anyway, so CUDA alone is the closest fallback
+		return USEGPU_CUDA;
+	}
+	return USEGPU_CPU;
+}
+
+bool isExecutionProviderAvailable(const std::string &useGPU)
+{
+	static const std::map<std::string, std::string> providerNames = {
+		{USEGPU_CPU, "CPUExecutionProvider"},
+		{USEGPU_DML, "DmlExecutionProvider"},
+		{USEGPU_CUDA, "CUDAExecutionProvider"},
+		{USEGPU_TENSORRT, "TensorrtExecutionProvider"},
+		{USEGPU_COREML, "CoreMLExecutionProvider"},
+		{USEGPU_XNNPACK, "XnnpackExecutionProvider"},
+		{USEGPU_DNNL, "DnnlExecutionProvider"},
+	};
+	auto it = providerNames.find(useGPU);
+	if (it == providerNames.end()) {
+		return false;
+	}
+	const std::vector<std::string> available = Ort::GetAvailableProviders();
+	return std::find(available.begin(), available.end(), it->second) !=
+	       available.end();
+}
+
+bool isCpuExecutionProvider(const std::string &provider)
+{
+	return provider == USEGPU_CPU || provider == USEGPU_XNNPACK ||
+	       provider == USEGPU_DNNL;
+}
+
+/**
+  * @brief Get the symbolic names of the input dims of the model (empty for fixed dims)
+  *
+  * The names are read from an unoptimized session, memoized per model file.
+*/
+static std::vector<std::vector<std::string>>
+getSymbolicInputDims(ORTModelData *tf)
+{
+	static std::mutex memoMutex;
+	static std::map<std::filesystem::path,
+			std::vector<std::vector<std::string>>>
+		memo;
+
+	const std::filesystem::path modelPath(tf->modelFilepath);
+	{
+		std::lock_guard<std::mutex> lock(memoMutex);
+		auto it = memo.find(modelPath);
+		if (it != memo.end()) {
+			return it->second;
+		}
+	}
+
+	Ort::SessionOptions inspectOptions;
+	inspectOptions.SetGraphOptimizationLevel(
+		GraphOptimizationLevel::ORT_DISABLE_ALL);
+	inspectOptions.DisablePerSessionThreads();
+	Ort::Session inspectSession(*tf->env, tf->modelFilepath.c_str(),
+				    inspectOptions);
+
+	std::vector<std::vector<std::string>> symbolicDims;
+	for (size_t i = 0; i < inspectSession.GetInputCount(); i++) {
+		const Ort::TypeInfo typeInfo = inspectSession.GetInputTypeInfo(i);
+		const auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+		const std::vector<const char *> names =
+			tensorInfo.GetSymbolicDimensions();
+		symbolicDims.emplace_back(names.begin(), names.end());
+	}
+
+	std::lock_guard<std::mutex> lock(memoMutex);
+	memo[modelPath] = symbolicDims;
+	return symbolicDims;
+}
+
+/**
+  * @brief Get free dimension overrides that pin the batch, height and width of the
+  * image input to the requested inference resolution
+  *
+  * Height and width are only overridden if their names are not shared with other
+  * inputs (e.g. recurrent state at a lower resolution); ORT still accepts the
+  * requested shape at runtime, the session is just not specialized for it.
+*/
+static std::vector<std::pair<std::string, int64_t>>
+getSpatialDimOverrides(ORTModelData *tf)
+{
+	std::vector<std::pair<std::string, int64_t>> overrides;
+
+	const std::vector<std::vector<std::string>> symbolicDims =
+		getSymbolicInputDims(tf);
+	size_t heightIndex, widthIndex;
+	tf->model->getInputSpatialDimIndices(heightIndex, widthIndex);
+	if (symbolicDims.empty() || symbolicDims[0].size() <= widthIndex) {
+		return overrides;
+	}
+
+	const std::pair<size_t, int64_t> imageDims[] = {
+		{0, 1},
+		{heightIndex, tf->model->requestedHeight},
+		{widthIndex, tf->model->requestedWidth},
+	};
+	for (const auto &imageDim : imageDims) {
+		const std::string &name = symbolicDims[0][imageDim.first];
+		if (name.empty()) {
+			continue;
+		}
+		bool shared = false;
+		for (size_t i = 0; i < symbolicDims.size() && imageDim.first > 0;
+		     i++) {
+			for (size_t j = 0; j < symbolicDims[i].size(); j++) {
+				if ((i != 0 || j != imageDim.first) &&
+				    symbolicDims[i][j] == name) {
+					shared = true;
+				}
+			}
+		}
+		if (!shared) {
+			overrides.emplace_back(name, imageDim.second);
+		}
+	}
+	return overrides;
+}
+
+static int createOrtSessionWithProvider(ORTModelData *tf,
+					const std::string &provider)
+{
 	Ort::SessionOptions sessionOptions;
 
 	sessionOptions.SetGraphOptimizationLevel(
 		GraphOptimizationLevel::ORT_ENABLE_ALL);
-	if (tf->useGPU != USEGPU_CPU) {
+	if (!isCpuExecutionProvider(provider)) {
 		sessionOptions.DisableMemPattern();
 		sessionOptions.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+		// The CPU fallback kernels share the environment's pool
+		sessionOptions.DisablePerSessionThreads();
+	} else if (provider == USEGPU_XNNPACK) {
+		// XNNPACK runs its own thread pool; a second spinning ORT pool would
+		// only compete with it for the same cores.
+		sessionOptions.SetInterOpNumThreads(1);
+		sessionOptions.SetIntraOpNumThreads(1);
+		sessionOptions.AddConfigEntry("session.intra_op.allow_spinning",
+					      "0");
+	} else if (tf->numThreads == 0) {
+		// The shared pool of the environment, sized to the CPU budget
+		sessionOptions.DisablePerSessionThreads();
 	} else {
+		// Opted out of the shared pool, with a pool of its own
 		sessionOptions.SetInterOpNumThreads(tf->numThreads);
 		sessionOptions.SetIntraOpNumThreads(tf->numThreads);
+		sessionOptions.AddConfigEntry("session.intra_op.allow_spinning",
+					      isOrtSpinningAllowed() ? "1"
+								     : "0");
+		if (!getThreadPlacement().isDefault()) {
+			sessionOptions.SetCustomCreateThreadFn(
+				createOrtPoolThread);
+			sessionOptions.SetCustomJoinThreadFn(joinOrtPoolThread);
+		}
 	}
 
 	char *modelFilepath_rawPtr =
@@ -62,9 +308,35 @@ int createOrtSession(filter_data *tf)
 	bfree(modelFilepath_rawPtr);
 
 	try {
+		// Specialize the session for the requested inference resolution
+		std::string resolutionKey;
+		if (tf->model->requestedWidth > 0 &&
+		    tf->model->requestedHeight > 0) {
+			const auto dimOverrides = getSpatialDimOverrides(tf);
+			for (const auto &dimOverride : dimOverrides) {
+				sessionOptions.AddFreeDimensionOverrideByName(
+					dimOverride.first.c_str(),
+					dimOverride.second);
+				obs_log(LOG_INFO,
+					"Overriding dynamic dim %s of %s to %d",
+					dimOverride.first.c_str(),
+					tf->modelSelection.c_str(),
+					(int)dimOverride.second);
+			}
+			if (!dimOverrides.empty()) {
+				resolutionKey =
+					"|res=" +
+					std::to_string(
+						tf->model->requestedWidth) +
+					"x" +
+					std::to_string(
+						tf->model->requestedHeight);
+			}
+		}
+
 #if defined(__linux__) && defined(__x86_64__) && \
 	!defined(DISABLE_ONNXRUNTIME_GPU)
-		if (tf->useGPU == USEGPU_TENSORRT) {
+		if (provider == USEGPU_TENSORRT) {
 			const auto &api = Ort::GetApi();
 
 			// Folder in which TensorRT will place its cache
@@ -108,14 +380,14 @@ int createOrtSession(filter_data *tf)
 			// Append execution provider
 			sessionOptions.AppendExecutionProvider_TensorRT_V2(
 				*tensorrt_options);
-		} else if (tf->useGPU == USEGPU_CUDA) {
+		} else if (provider == USEGPU_CUDA) {
 			Ort::ThrowOnError(
 				OrtSessionOptionsAppendExecutionProvider_CUDA(
 					sessionOptions, 0));
 		}
 #endif
 #ifdef _WIN32
-		if (tf->useGPU == USEGPU_DML) {
+		if (provider == USEGPU_DML) {
 			auto &api = Ort::GetApi();
 			OrtDmlApi *dmlApi = nullptr;
 			Ort::ThrowOnError(api.GetExecutionProviderApi(
@@ -127,7 +399,7 @@ int createOrtSession(filter_data *tf)
 		}
 #endif
 #if defined(__APPLE__)
-		if (tf->useGPU == USEGPU_COREML) {
+		if (provider == USEGPU_COREML) {
 			uint32_t coreml_flags = 0;
 			coreml_flags |= COREML_FLAG_ENABLE_ON_SUBGRAPH;
 			Ort::ThrowOnError(
@@ -135,8 +407,59 @@ int createOrtSession(filter_data *tf)
 					sessionOptions, coreml_flags));
 		}
 #endif
-		tf->session.reset(new Ort::Session(
-			*tf->env, tf->modelFilepath.c_str(), sessionOptions));
+		if (provider == USEGPU_XNNPACK) {
+			// 0 threads runs XNNPACK on the CPU budget
+			const std::string xnnpackThreads = std::to_string(
+				tf->numThreads > 0 ? tf->numThreads
+						   : getCpuBudget());
+			sessionOptions.AppendExecutionProvider(
+				"XNNPACK",
+				{{"intra_op_num_threads", xnnpackThreads}});
+		} else if (provider == USEGPU_DNNL) {
+			const auto &api = Ort::GetApi();
+			OrtDnnlProviderOptions *dnnl_options;
+			Ort::ThrowOnError(
+				api.CreateDnnlProviderOptions(&dnnl_options));
+			std::vector<const char *> option_keys = {"use_arena"};
+			std::vector<const char *> option_values = {"1"};
+			OrtStatus *status = api.UpdateDnnlProviderOptions(
+				dnnl_options, option_keys.data(),
+				option_values.data(), option_keys.size());
+			if (status == nullptr) {
+				status = api.SessionOptionsAppendExecutionProvider_Dnnl(
+					sessionOptions,
+					dnnl_options);
+			}
+			api.ReleaseDnnlProviderOptions(dnnl_options);
+			Ort::ThrowOnError(status);
+		}
+
+		// Only the CPU EP produces a serializable optimized graph. Compiling EPs
+		// (TensorRT, DirectML, CoreML, XNNPACK, oneDNN) keep their own caches, if any.
+		std::string cacheKey;
+		if (provider == USEGPU_CPU) {
+			cacheKey = provider + "|opt=all" + resolutionKey;
+		}
+
+		// Release the previous session before its mapped model
+		tf->session.reset();
+		tf->mappedModel.reset();
+
+		const auto startTime = std::chrono::steady_clock::now();
+		bool warmStart = false;
+		tf->session.reset(createSessionWithModelCache(
+			*tf->env, tf->modelFilepath, sessionOptions, cacheKey,
+			tf->mappedModel, warmStart));
+		const double elapsedMs =
+			std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - startTime)
+				.count();
+		obs_log(LOG_INFO,
+			"Created ORT session for %s on %s in %.1f ms (%s)",
+			tf->modelSelection.c_str(), provider.c_str(), elapsedMs,
+			cacheKey.empty() ? "no cache"
+			: warmStart      ? "warm start from cache"
+					 : "cold start");
 	} catch (const std::exception &e) {
 		obs_log(LOG_ERROR, "%s", e.what());
 		return OBS_BGREMOVAL_ORT_SESSION_ERROR_STARTUP;
@@ -154,6 +477,13 @@ int createOrtSession(filter_data *tf)
 		return OBS_BGREMOVAL_ORT_SESSION_ERROR_INVALID_INPUT_OUTPUT;
 	}
 
+	if (tf->model->requestedWidth > 0 && !tf->model->dynamicSpatialDims) {
+		obs_log(LOG_INFO,
+			"Model %s has a fixed input resolution, ignoring the requested %ux%u",
+			tf->modelSelection.c_str(), tf->model->requestedWidth,
+			tf->model->requestedHeight);
+	}
+
 	for (size_t i = 0; i < tf->inputNames.size(); i++) {
 		obs_log(LOG_INFO,
 			"Model %s input %d: name %s shape (%d dim) %d x %d x %d x %d",
@@ -196,8 +526,79 @@ int createOrtSession(filter_data *tf)
 	return OBS_BGREMOVAL_ORT_SESSION_SUCCESS;
 }
 
-bool runFilterModelInference(filter_data *tf, const cv::Mat &imageBGRA,
-			     cv::Mat &output)
+int createOrtSession(ORTModelData *tf, const std::function<bool()> &warmUp,
+		     const std::function<bool()> &isCancelled)
+{
+	if (tf->model.get() == nullptr) {
+		obs_log(LOG_ERROR, "Model object is not initialized");
+		return OBS_BGREMOVAL_ORT_SESSION_ERROR_INVALID_MODEL;
+	}
+
+	if (tf->inferenceShortSide > 0 &&
+	    !tf->model->followsSourceResolution()) {
+		// Landscape 16:9, both sides a multiple of 16 so they divide evenly
+		// through the encoder strides
+		const auto alignTo16 = [](double size) {
+			return (uint32_t)std::max(1.0, std::round(size / 16.0)) *
+			       16;
+		};
+		tf->model->requestedHeight = alignTo16(tf->inferenceShortSide);
+		tf->model->requestedWidth =
+			alignTo16(tf->inferenceShortSide * 16.0 / 9.0);
+	}
+
+	int result = OBS_BGREMOVAL_ORT_SESSION_ERROR_STARTUP;
+	for (const std::string &provider :
+	     getExecutionProviderFallbackChain(tf->useGPU)) {
+		if (isCancelled && isCancelled()) {
+			return OBS_BGREMOVAL_ORT_SESSION_CANCELLED;
+		}
+		if (!isExecutionProviderAvailable(provider)) {
+			obs_log(LOG_WARNING,
+				"Execution provider %s is not available in this build",
+				provider.c_str());
+			continue;
+		}
+		result = createOrtSessionWithProvider(tf, provider);
+		if (result == OBS_BGREMOVAL_ORT_SESSION_SUCCESS) {
+			tf->activeProvider = provider;
+			const bool warmedUp = !warmUp || warmUp();
+			if (isCancelled && isCancelled()) {
+				// Not a failure of the provider, the build is no longer needed
+				return OBS_BGREMOVAL_ORT_SESSION_CANCELLED;
+			}
+			if (!warmedUp) {
+				// The provider starts but can't run the model
+				result = OBS_BGREMOVAL_ORT_SESSION_ERROR_WARMUP;
+				obs_log(LOG_WARNING,
+					"Failed to warm up %s on %s, trying the next execution provider",
+					tf->modelSelection.c_str(),
+					provider.c_str());
+				continue;
+			}
+			obs_log(LOG_INFO,
+				"Active execution provider for %s: %s (requested %s)",
+				tf->modelSelection.c_str(), provider.c_str(),
+				tf->useGPU.c_str());
+			break;
+		}
+		if (result != OBS_BGREMOVAL_ORT_SESSION_ERROR_STARTUP) {
+			// Missing or broken model, another provider won't help
+			break;
+		}
+		obs_log(LOG_WARNING,
+			"Failed to start %s on %s, trying the next execution provider",
+			tf->modelSelection.c_str(), provider.c_str());
+	}
+	return result;
+}
+
+/**
+  * @brief Check the session is ready and follow the source size in the models that
+  * run at it
+*/
+static bool beginFilterModelInference(ORTModelData *tf, int sourceWidth,
+				      int sourceHeight)
 {
 	if (tf->session.get() == nullptr) {
 		// Onnx runtime session is not initialized. Problem in initialization
@@ -208,23 +609,30 @@ bool runFilterModelInference(filter_data *tf, const cv::Mat &imageBGRA,
 		return false;
 	}
 
-	// To RGB
-	cv::Mat imageRGB;
-	cv::cvtColor(imageBGRA, imageRGB, cv::COLOR_BGRA2RGB);
-
-	// Resize to network input size
-	uint32_t inputWidth, inputHeight;
-	tf->model->getNetworkInputSize(tf->inputDims, inputWidth, inputHeight);
-
-	cv::Mat resizedImageRGB;
-	cv::resize(imageRGB, resizedImageRGB,
-		   cv::Size(inputWidth, inputHeight));
-
-	// Prepare input to nework
-	cv::Mat resizedImage, preprocessedImage;
-	resizedImageRGB.convertTo(resizedImage, CV_32F);
+	// Models that run at the source resolution follow its changes, unless the filter
+	// rebuilds the session for the new size in the background
+	if (!tf->rebuildsForSourceSize &&
+	    tf->model->adaptToSourceSize(sourceWidth, sourceHeight,
+					 tf->inputDims, tf->outputDims)) {
+		tf->model->allocateTensorBuffers(
+			tf->inputDims, tf->outputDims, tf->outputTensorValues,
+			tf->inputTensorValues, tf->inputTensor,
+			tf->outputTensor);
+		tf->sourceWidth = (uint32_t)sourceWidth;
+		tf->sourceHeight = (uint32_t)sourceHeight;
+	}
+	return true;
+}
 
-	tf->model->prepareInputToNetwork(resizedImage, preprocessedImage);
+/**
+  * @brief Run the network on tf->resizedImage, the network-sized RGB float image
+*/
+static void finishFilterModelInference(ORTModelData *tf, uint32_t inputWidth,
+				       uint32_t inputHeight, cv::Mat &output)
+{
+	// Prepare input to nework. The buffers live in tf so steady-state frames reuse them.
+	cv::Mat &preprocessedImage = tf->preprocessedImage;
+	tf->model->prepareInputToNetwork(tf->resizedImage, preprocessedImage);
 
 	tf->model->loadInputToTensor(preprocessedImage, inputWidth, inputHeight,
 				     tf->inputTensorValues);
@@ -241,13 +649,126 @@ bool runFilterModelInference(filter_data *tf, const cv::Mat &imageBGRA,
 
 	// Assign output to input in some models that have temporal information
 	tf->model->assignOutputToInput(tf->outputTensorValues,
-				       tf->inputTensorValues);
+				       tf->inputTensorValues, tf->outputTensor,
+				       tf->inputTensor);
 
 	// Post-process output. The image will now be in [0,1] float, BHWC format
 	tf->model->postprocessOutput(outputImage);
 
-	// Convert [0,1] float to CV_8U [0,255]
-	outputImage.convertTo(output, CV_8U, 255.0);
+	// Convert [0,1] float to CV_8U [0,255], unless the output holds parameters.
+	// The float output may point into the tensor buffer, so it is copied out.
+	if (tf->model->keepsFloatOutput()) {
+		outputImage.copyTo(output);
+	} else {
+		outputImage.convertTo(output, CV_8U, 255.0);
+	}
+
+	if (tf->firstOutputPending) {
+		tf->firstOutputPending = false;
+		tf->timeToFirstOutputMs =
+			std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() -
+				tf->requestTime)
+				.count();
+		obs_log(LOG_INFO, "Time to first output with %s on %s: %.1f ms",
+			tf->modelSelection.c_str(), tf->activeProvider.c_str(),
+			tf->timeToFirstOutputMs);
+	}
+}
+
+bool runFilterModelInference(ORTModelData *tf, const cv::Mat &imageBGRA,
+			     cv::Mat &output)
+{
+	if (!beginFilterModelInference(tf, imageBGRA.cols, imageBGRA.rows)) {
+		return false;
+	}
 
+	// Resize to network input size. Resizing before the channel swap converts only
+	// the (usually much smaller) network-sized image.
+	uint32_t inputWidth, inputHeight;
+	tf->model->getNetworkInputSize(tf->inputDims, inputWidth, inputHeight);
+
+	cv::resize(imageBGRA, tf->resizedImageBGRA,
+		   cv::Size(inputWidth, inputHeight));
+
+	// To RGB
+	cv::cvtColor(tf->resizedImageBGRA, tf->resizedImageRGB,
+		     cv::COLOR_BGRA2RGB);
+	tf->resizedImageRGB.convertTo(tf->resizedImage, CV_32F);
+
+	finishFilterModelInference(tf, inputWidth, inputHeight, output);
+	return true;
+}
+
+bool runFilterModelInference(ORTModelData *tf, const YuvImage &imageYUV,
+			     cv::Mat &output)
+{
+	if (!beginFilterModelInference(tf, imageYUV.width(),
+				       imageYUV.height())) {
+		return false;
+	}
+
+	uint32_t inputWidth, inputHeight;
+	tf->model->getNetworkInputSize(tf->inputDims, inputWidth, inputHeight);
+
+	// Resize, convert to RGB and to float in one pass over the network-sized image
+	yuvToNetworkRGB(imageYUV, (int)inputWidth, (int)inputHeight,
+			tf->resizedImage);
+
+	finishFilterModelInference(tf, inputWidth, inputHeight, output);
+	return true;
+}
+
+bool warmUpOrtSession(ORTModelData *tf, uint32_t runs,
+		      const std::function<bool()> &isCancelled)
+{
+	// Shape the models that run at the source resolution for it, the warm-up and the
+	// first real frame run at that shape
+	if (tf->sourceWidth > 0 && tf->sourceHeight > 0 &&
+	    tf->model->adaptToSourceSize(tf->sourceWidth, tf->sourceHeight,
+					 tf->inputDims, tf->outputDims)) {
+		tf->model->allocateTensorBuffers(
+			tf->inputDims, tf->outputDims, tf->outputTensorValues,
+			tf->inputTensorValues, tf->inputTensor,
+			tf->outputTensor);
+	}
+
+	uint32_t inputWidth, inputHeight;
+	tf->model->getNetworkInputSize(tf->inputDims, inputWidth, inputHeight);
+
+	// A mid-gray frame at network resolution goes through the full pre/post pipeline
+	const cv::Mat dummyBGRA(inputHeight, inputWidth, CV_8UC4,
+				cv::Scalar(128, 128, 128, 255));
+	cv::Mat dummyOutput;
+
+	double firstRunMs = 0.0, lastRunMs = 0.0;
+	uint32_t i = 0;
+	try {
+		for (; i < runs && !isCancelled(); i++) {
+			const auto startTime = std::chrono::steady_clock::now();
+			runFilterModelInference(tf, dummyBGRA, dummyOutput);
+			lastRunMs = std::chrono::duration<double, std::milli>(
+					    std::chrono::steady_clock::now() -
+					    startTime)
+					    .count();
+			if (i == 0) {
+				firstRunMs = lastRunMs;
+			}
+		}
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Session warm-up failed: %s", e.what());
+		return false;
+	}
+
+	// Don't leak warm-up state (e.g. recurrent tensors) into the first real frame
+	for (auto &values : tf->inputTensorValues) {
+		std::fill(values.begin(), values.end(), 0.0f);
+	}
+
+	if (i > 0) {
+		obs_log(LOG_INFO,
+			"Warmed up %s with %u runs: first %.1f ms, last %.1f ms",
+			tf->modelSelection.c_str(), i, firstRunMs, lastRunMs);
+	}
 	return true;
 }
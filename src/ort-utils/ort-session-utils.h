@@ -3,17 +3,93 @@
 
 #include <opencv2/core/types.hpp>
 
-#include "FilterData.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ORTModelData.h"
+#include "cv-utils/yuv-kernels.h"
 
 #define OBS_BGREMOVAL_ORT_SESSION_ERROR_FILE_NOT_FOUND 1
 #define OBS_BGREMOVAL_ORT_SESSION_ERROR_INVALID_MODEL 2
 #define OBS_BGREMOVAL_ORT_SESSION_ERROR_INVALID_INPUT_OUTPUT 3
 #define OBS_BGREMOVAL_ORT_SESSION_ERROR_STARTUP 5
+#define OBS_BGREMOVAL_ORT_SESSION_ERROR_WARMUP 6
+#define OBS_BGREMOVAL_ORT_SESSION_CANCELLED 7
 #define OBS_BGREMOVAL_ORT_SESSION_SUCCESS 0
 
-int createOrtSession(filter_data *tf);
+/**
+  * @brief The ORT environment of all the sessions of the plugin
+  *
+  * It owns the global intra-op thread pool, sized to the CPU budget, that sessions
+  * with 0 threads share. OpenCV's pool is sized to the same budget. ORT keeps a
+  * single environment per process, so every filter must get it from here. It is
+  * released with the last filter.
+*/
+std::shared_ptr<Ort::Env> getSharedOrtEnv();
+
+/**
+  * @brief Create the session, walking the execution provider fallback chain of tf->useGPU
+  * until one starts up. The provider that was used is stored in tf->activeProvider.
+  *
+  * @param warmUp Run on each session that starts up, a provider whose warm-up fails
+  * falls back to the next one like a provider that fails to start
+  * @param isCancelled Checked between the providers and after a warm-up, the walk
+  * stops with OBS_BGREMOVAL_ORT_SESSION_CANCELLED once it returns true
+*/
+int createOrtSession(ORTModelData *tf,
+		     const std::function<bool()> &warmUp = nullptr,
+		     const std::function<bool()> &isCancelled = nullptr);
+
+/**
+  * @brief Get the ordered list of execution providers to try for a requested one,
+  * starting with the requested provider and ending with the default CPU provider.
+*/
+std::vector<std::string>
+getExecutionProviderFallbackChain(const std::string &useGPU);
+
+/**
+  * @brief Get the provider to fall back to when a session on the given provider fails
+  * at runtime, or an empty string if there is nothing left to fall back to.
+*/
+std::string getNextExecutionProvider(const std::string &provider);
+
+/**
+  * @brief Check if the ONNX Runtime build we are linked against includes a provider
+*/
+bool isExecutionProviderAvailable(const std::string &useGPU);
 
-bool runFilterModelInference(filter_data *tf, const cv::Mat &imageBGRA,
+/**
+  * @brief Check if a provider runs on the CPU, where the thread count applies
+*/
+bool isCpuExecutionProvider(const std::string &provider);
+
+/**
+  * @brief Run the model on a BGRA frame
+  *
+  * The output is CV_8U, or [0,1] float for models that keep a float output.
+*/
+bool runFilterModelInference(ORTModelData *tf, const cv::Mat &imageBGRA,
+			     cv::Mat &output);
+
+/**
+  * @brief Run the model on a camera frame in its YUV layout, converting it to the
+  * network input in a single pass
+*/
+bool runFilterModelInference(ORTModelData *tf, const YuvImage &imageYUV,
 			     cv::Mat &output);
 
+/**
+  * @brief Run dummy inferences so the first real frame doesn't pay for arena growth,
+  * thread-pool spin-up and lazy kernel initialization.
+  *
+  * @param tf The session to warm up (not yet published)
+  * @param runs Number of dummy inferences
+  * @param isCancelled Checked between runs, to stop warming up a superseded session
+  * @return false if an inference failed
+*/
+bool warmUpOrtSession(ORTModelData *tf, uint32_t runs,
+		      const std::function<bool()> &isCancelled);
+
 #endif /* ORT_SESSION_UTILS_H */
@@ -40,6 +40,7 @@ bool obs_module_load(void)
 	obs_log(LOG_INFO, "Plugin loaded successfully (version %s)",
 		PLUGIN_VERSION);
 
+	// Runs on its own thread, a slow or unreachable server doesn't delay the start
 	check_update();
 
 	return true;
@@ -47,5 +48,6 @@ bool obs_module_load(void)
 
 void obs_module_unload()
 {
+	stop_update_check();
 	obs_log(LOG_INFO, "plugin unloaded");
 }
@@ -1,5 +1,32 @@
+#pragma once
+
 #include <string>
 #include <functional>
 
-void fetchStringFromUrl(const char *urlString,
-			std::function<void(std::string, int)> callback);
+// Bounds of a request, so an offline or firewalled machine can't hold the caller
+// for the TCP timeouts
+#define UPDATE_CHECKER_CONNECT_TIMEOUT_MS 5000
+#define UPDATE_CHECKER_TOTAL_TIMEOUT_MS 10000
+
+#define HTTP_STATUS_NOT_MODIFIED 304
+
+struct FetchResponse {
+	// 0 if a 2xx or 304 response arrived, a client error code otherwise
+	int error = 0;
+	long statusCode = 0;
+	std::string body;
+	std::string etag;
+	std::string lastModified;
+};
+
+/**
+  * @brief GET a URL, conditionally if a validator of a previous response is given
+  *
+  * @param etag Sent as If-None-Match if not empty
+  * @param lastModified Sent as If-Modified-Since if not empty
+  * @param callback Gets the response, a 304 with an empty body if the previous
+  * response is still current
+*/
+void fetchStringFromUrl(const char *urlString, const std::string &etag,
+			const std::string &lastModified,
+			std::function<void(const FetchResponse &)> callback);
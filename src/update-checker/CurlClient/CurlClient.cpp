@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include <string>
 #include <functional>
 
@@ -6,6 +8,8 @@
 #include <obs.h>
 #include <plugin-support.h>
 
+#include "update-checker/Client.hpp"
+
 const std::string userAgent = std::string(PLUGIN_NAME) + "/" + PLUGIN_VERSION;
 
 static std::size_t writeFunc(void *ptr, std::size_t size, size_t nmemb,
@@ -15,29 +19,87 @@ static std::size_t writeFunc(void *ptr, std::size_t size, size_t nmemb,
 	return size * nmemb;
 }
 
-void fetchStringFromUrl(const char *urlString,
-			std::function<void(std::string, int)> callback)
+/**
+  * @brief Keep the validators of the response, from its header lines
+*/
+static std::size_t headerFunc(char *buffer, std::size_t size, size_t nitems,
+			      FetchResponse *response)
 {
+	const std::size_t length = size * nitems;
+	std::string line(buffer, length);
+	const std::size_t colon = line.find(':');
+	if (colon == std::string::npos) {
+		return length;
+	}
+	std::string name = line.substr(0, colon);
+	std::transform(name.begin(), name.end(), name.begin(),
+		       [](unsigned char c) { return (char)std::tolower(c); });
+	const std::size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+	const std::size_t valueEnd = line.find_last_not_of(" \t\r\n");
+	const std::string value =
+		valueStart == std::string::npos || valueEnd < valueStart
+			? ""
+			: line.substr(valueStart, valueEnd - valueStart + 1);
+	if (name == "etag") {
+		response->etag = value;
+	} else if (name == "last-modified") {
+		response->lastModified = value;
+	}
+	return length;
+}
+
+void fetchStringFromUrl(const char *urlString, const std::string &etag,
+			const std::string &lastModified,
+			std::function<void(const FetchResponse &)> callback)
+{
+	FetchResponse response;
 	CURL *curl = curl_easy_init();
 	if (!curl) {
 		obs_log(LOG_INFO, "Failed to initialize curl");
-		callback("", CURL_LAST);
+		response.error = CURL_LAST;
+		callback(response);
 		return;
 	}
 
-	std::string responseBody;
+	struct curl_slist *headers = nullptr;
+	if (!etag.empty()) {
+		headers = curl_slist_append(
+			headers, ("If-None-Match: " + etag).c_str());
+	}
+	if (!lastModified.empty()) {
+		headers = curl_slist_append(
+			headers,
+			("If-Modified-Since: " + lastModified).c_str());
+	}
+
 	curl_easy_setopt(curl, CURLOPT_URL, urlString);
 	curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent.c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunc);
-	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerFunc);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+	curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS,
+			 (long)UPDATE_CHECKER_CONNECT_TIMEOUT_MS);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS,
+			 (long)UPDATE_CHECKER_TOTAL_TIMEOUT_MS);
+	// Timeouts must not use signals off the main thread
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
 	CURLcode code = curl_easy_perform(curl);
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.statusCode);
 	curl_easy_cleanup(curl);
+	curl_slist_free_all(headers);
 
-	if (code == CURLE_OK) {
-		callback(responseBody, 0);
-	} else {
-		obs_log(LOG_INFO, "Failed to get latest release info");
-		callback("", code);
+	if (code != CURLE_OK) {
+		obs_log(LOG_INFO, "Failed to get latest release info: %s",
+			curl_easy_strerror(code));
+		response.error = code;
+	} else if (response.statusCode != HTTP_STATUS_NOT_MODIFIED &&
+		   (response.statusCode < 200 || response.statusCode > 299)) {
+		obs_log(LOG_INFO, "Latest release info request returned %ld",
+			response.statusCode);
+		response.error = CURLE_HTTP_RETURNED_ERROR;
 	}
+	callback(response);
 }
@@ -6,36 +6,69 @@
 #include <obs.h>
 #include <plugin-support.h>
 
-void dispatch(const std::function<void(std::string, int)> &callback, std::string responseBody, int errorCode)
+#include "update-checker/Client.hpp"
+
+void dispatch(const std::function<void(const FetchResponse &)> &callback, FetchResponse response)
 {
     dispatch_async(dispatch_get_main_queue(), ^{
-        callback(responseBody, errorCode);
+        callback(response);
     });
 }
 
-void fetchStringFromUrl(const char *urlString, std::function<void(std::string, int)> callback)
+static std::string headerValue(NSHTTPURLResponse *response, NSString *name)
+{
+    NSString *value = [response valueForHTTPHeaderField:name];
+    return value == nil ? "" : std::string(value.UTF8String);
+}
+
+void fetchStringFromUrl(const char *urlString, const std::string &etag, const std::string &lastModified,
+                        std::function<void(const FetchResponse &)> callback)
 {
     NSString *urlNsString = [[NSString alloc] initWithUTF8String:urlString];
-    NSURLSession *session = [NSURLSession sharedSession];
+    NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+    // NSURLSession has no connect timeout, the idle timeout bounds an unreachable host
+    configuration.timeoutIntervalForRequest = UPDATE_CHECKER_CONNECT_TIMEOUT_MS / 1000.0;
+    configuration.timeoutIntervalForResource = UPDATE_CHECKER_TOTAL_TIMEOUT_MS / 1000.0;
+    // Pass 304s through rather than answering from the URL cache
+    configuration.requestCachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    NSURLSession *session = [NSURLSession sessionWithConfiguration:configuration];
     NSURL *url = [NSURL URLWithString:urlNsString];
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:url];
+    if (!etag.empty()) {
+        [request setValue:[NSString stringWithUTF8String:etag.c_str()] forHTTPHeaderField:@"If-None-Match"];
+    }
+    if (!lastModified.empty()) {
+        [request setValue:[NSString stringWithUTF8String:lastModified.c_str()]
+            forHTTPHeaderField:@"If-Modified-Since"];
+    }
     NSURLSessionDataTask *task = [session
-          dataTaskWithURL:url
-        completionHandler:^(NSData *_Nullable data, NSURLResponse *_Nullable response, NSError *_Nullable error) {
-            if (error != NULL) {
-                obs_log(LOG_INFO, "error");
-                dispatch(callback, "", 1);
-            } else if (response == NULL) {
-                dispatch(callback, "", 2);
-            } else if (data == NULL || data.length == 0) {
-                dispatch(callback, "", 3);
-            } else if (![response isKindOfClass:NSHTTPURLResponse.class]) {
-                dispatch(callback, "", 4);
-            } else {
-                std::string responseBody((const char *) data.bytes, data.length);
-                NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *) response;
-                NSInteger code = httpResponse.statusCode;
-                dispatch(callback, responseBody, code < 200 || code > 299 ? 5 : 0);
-            }
-        }];
+        dataTaskWithRequest:request
+          completionHandler:^(NSData *_Nullable data, NSURLResponse *_Nullable response, NSError *_Nullable error) {
+              FetchResponse result;
+              if (error != NULL) {
+                  obs_log(LOG_INFO, "error");
+                  result.error = 1;
+              } else if (response == NULL) {
+                  result.error = 2;
+              } else if (![response isKindOfClass:NSHTTPURLResponse.class]) {
+                  result.error = 4;
+              } else {
+                  NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *) response;
+                  result.statusCode = httpResponse.statusCode;
+                  result.etag = headerValue(httpResponse, @"ETag");
+                  result.lastModified = headerValue(httpResponse, @"Last-Modified");
+                  if (result.statusCode == HTTP_STATUS_NOT_MODIFIED) {
+                      // The previous response is still current
+                  } else if (data == NULL || data.length == 0) {
+                      result.error = 3;
+                  } else if (result.statusCode < 200 || result.statusCode > 299) {
+                      result.error = 5;
+                  } else {
+                      result.body = std::string((const char *) data.bytes, data.length);
+                  }
+              }
+              dispatch(callback, result);
+          }];
     [task resume];
+    [session finishTasksAndInvalidate];
 }
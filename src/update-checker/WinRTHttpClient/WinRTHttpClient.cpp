@@ -1,40 +1,120 @@
+#include <algorithm>
+#include <chrono>
 #include <functional>
 
 #include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Web.Http.Filters.h>
 #include <winrt/Windows.Web.Http.Headers.h>
 #include <winrt/windows.storage.streams.h>
 #include <plugin-support.h>
 
+#include "update-checker/Client.hpp"
+
+using winrt::Windows::Foundation::AsyncStatus;
+using winrt::Windows::Foundation::TimeSpan;
 using winrt::Windows::Foundation::Uri;
 using winrt::Windows::Storage::Streams::IBuffer;
 using winrt::Windows::Web::Http::HttpClient;
+using winrt::Windows::Web::Http::HttpMethod;
+using winrt::Windows::Web::Http::HttpRequestMessage;
 using winrt::Windows::Web::Http::HttpResponseMessage;
+using winrt::Windows::Web::Http::HttpStatusCode;
 using winrt::Windows::Web::Http::IHttpContent;
+using winrt::Windows::Web::Http::Filters::HttpBaseProtocolFilter;
+using winrt::Windows::Web::Http::Filters::HttpCacheReadBehavior;
+using winrt::Windows::Web::Http::Filters::HttpCacheWriteBehavior;
 
 winrt::hstring userAgent = winrt::to_hstring(PLUGIN_NAME) + L"/" +
 			   winrt::to_hstring(PLUGIN_VERSION);
 
-void fetchStringFromUrl(const char *urlString,
-			std::function<void(std::string, int)> callback)
+/**
+  * @brief Get a header of the response or of its content, empty if it has none
+*/
+template<typename Headers>
+static std::string headerValue(const Headers &headers, const wchar_t *name)
+{
+	if (!headers.HasKey(name)) {
+		return "";
+	}
+	return winrt::to_string(headers.Lookup(name));
+}
+
+void fetchStringFromUrl(const char *urlString, const std::string &etag,
+			const std::string &lastModified,
+			std::function<void(const FetchResponse &)> callback)
 {
-	HttpClient httpClient;
+	FetchResponse response;
+	// Pass 304s through rather than answering from the WinINet cache
+	HttpBaseProtocolFilter filter;
+	filter.CacheControl().ReadBehavior(HttpCacheReadBehavior::NoCache);
+	filter.CacheControl().WriteBehavior(HttpCacheWriteBehavior::NoCache);
+	HttpClient httpClient(filter);
 	auto headers(httpClient.DefaultRequestHeaders());
 	headers.UserAgent().TryParseAdd(userAgent);
 	Uri requestUri(winrt::to_hstring(urlString));
+	HttpRequestMessage requestMessage(HttpMethod::Get(), requestUri);
+	if (!etag.empty()) {
+		requestMessage.Headers().TryAppendWithoutValidation(
+			L"If-None-Match", winrt::to_hstring(etag));
+	}
+	if (!lastModified.empty()) {
+		requestMessage.Headers().TryAppendWithoutValidation(
+			L"If-Modified-Since", winrt::to_hstring(lastModified));
+	}
 	HttpResponseMessage httpResponseMessage;
 	IBuffer httpResponseBuffer;
+	// HttpClient has no connect timeout, the whole request is bounded instead
+	const auto deadline =
+		std::chrono::steady_clock::now() +
+		std::chrono::milliseconds(UPDATE_CHECKER_TOTAL_TIMEOUT_MS);
+	const auto remaining = [&deadline]() {
+		return std::chrono::duration_cast<TimeSpan>(
+			std::max(deadline - std::chrono::steady_clock::now(),
+				 std::chrono::steady_clock::duration::zero()));
+	};
 	try {
-		httpResponseMessage = httpClient.GetAsync(requestUri).get();
-		httpResponseMessage.EnsureSuccessStatusCode();
+		auto request = httpClient.SendRequestAsync(requestMessage);
+		if (request.wait_for(remaining()) != AsyncStatus::Completed) {
+			request.Cancel();
+			response.error = 2;
+			callback(response);
+			return;
+		}
+		httpResponseMessage = request.GetResults();
 		IHttpContent httpContent = httpResponseMessage.Content();
-		httpResponseBuffer = httpContent.ReadAsBufferAsync().get();
+		response.statusCode = (long)httpResponseMessage.StatusCode();
+		response.etag =
+			headerValue(httpResponseMessage.Headers(), L"ETag");
+		if (httpContent) {
+			// Last-Modified is a content header
+			response.lastModified = headerValue(
+				httpContent.Headers(), L"Last-Modified");
+		}
+		if (httpResponseMessage.StatusCode() ==
+		    HttpStatusCode::NotModified) {
+			// The previous response is still current
+			callback(response);
+			return;
+		}
+		httpResponseMessage.EnsureSuccessStatusCode();
+		auto read = httpContent.ReadAsBufferAsync();
+		if (read.wait_for(remaining()) != AsyncStatus::Completed) {
+			read.Cancel();
+			response.error = 2;
+			callback(response);
+			return;
+		}
+		httpResponseBuffer = read.GetResults();
 
 		uint8_t *data = httpResponseBuffer.data();
-		std::string str((const char *)data,
-				httpResponseBuffer.Length());
-		callback(str, 0);
+		response.body = std::string((const char *)data,
+					    httpResponseBuffer.Length());
+		callback(response);
 	} catch (winrt::hresult_error const &ex) {
-		std::string str(winrt::to_string(ex.message()));
-		callback(str, 1);
+		obs_log(LOG_INFO, "Failed to get latest release info: %s",
+			winrt::to_string(ex.message()).c_str());
+		response.error = 1;
+		callback(response);
 	}
 }
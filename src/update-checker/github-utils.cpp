@@ -1,30 +1,157 @@
 #include <cstddef>
+#include <ctime>
 #include <string>
 
 #include <obs.h>
+#include <obs-module.h>
+#include <util/platform.h>
 
 #include "Client.hpp"
 #include "github-utils.h"
+#include "obs-utils/obs-config-utils.h"
 #include "plugin-support.h"
 
 static const std::string GITHUB_LATEST_RELEASE_URL =
 	"https://api.github.com/repos/occ-ai/obs-backgroundremoval/releases/latest";
 
+// Hours a lookup is served from the cache before the server is asked again, unless
+// the "update_check_interval_hours" config item sets another interval
+static const int64_t DEFAULT_UPDATE_CHECK_INTERVAL_HOURS = 24;
+static const char *const RELEASE_CACHE_FILE = "update-check-cache.json";
+
+/**
+  * @brief The last release lookup, kept in the module config folder
+*/
+struct ReleaseCache {
+	std::string url;
+	std::string version;
+	std::string body;
+	std::string etag;
+	std::string lastModified;
+	// When the server was last asked, in seconds since the epoch
+	int64_t checkedAt = 0;
+};
+
+static bool loadReleaseCache(ReleaseCache &cache)
+{
+	char *path = obs_module_config_path(RELEASE_CACHE_FILE);
+	if (!path) {
+		return false;
+	}
+	obs_data_t *data = obs_data_create_from_json_file_safe(path, "bak");
+	bfree(path);
+	if (!data) {
+		return false;
+	}
+	cache.url = obs_data_get_string(data, "url");
+	cache.version = obs_data_get_string(data, "version");
+	cache.body = obs_data_get_string(data, "body");
+	cache.etag = obs_data_get_string(data, "etag");
+	cache.lastModified = obs_data_get_string(data, "last_modified");
+	cache.checkedAt = obs_data_get_int(data, "checked_at");
+	obs_data_release(data);
+	return true;
+}
+
+static void saveReleaseCache(const ReleaseCache &cache)
+{
+	char *folder = obs_module_config_path(NULL);
+	char *path = obs_module_config_path(RELEASE_CACHE_FILE);
+	if (!folder || !path) {
+		bfree(folder);
+		bfree(path);
+		return;
+	}
+	os_mkdirs(folder);
+	obs_data_t *data = obs_data_create();
+	obs_data_set_string(data, "url", cache.url.c_str());
+	obs_data_set_string(data, "version", cache.version.c_str());
+	obs_data_set_string(data, "body", cache.body.c_str());
+	obs_data_set_string(data, "etag", cache.etag.c_str());
+	obs_data_set_string(data, "last_modified", cache.lastModified.c_str());
+	obs_data_set_int(data, "checked_at", cache.checkedAt);
+	if (!obs_data_save_json_safe(data, path, "tmp", "bak")) {
+		obs_log(LOG_INFO, "Failed to save the release info cache");
+	}
+	obs_data_release(data);
+	bfree(folder);
+	bfree(path);
+}
+
 void github_utils_get_release_information(
 	std::function<void(github_utils_release_information)> callback)
 {
-	fetchStringFromUrl(GITHUB_LATEST_RELEASE_URL.c_str(), [callback](
-								      std::string
-									      responseBody,
-								      int code) {
-		if (code != 0)
+	// The "update_check_url" config item points the check at another server, e.g. a
+	// local stand-in for testing
+	std::string url;
+	if (getStringFromConfig("update_check_url", url, "") !=
+		    OBS_BGREMOVAL_CONFIG_SUCCESS ||
+	    url.empty()) {
+		url = GITHUB_LATEST_RELEASE_URL;
+	}
+
+	int64_t intervalHours = 0;
+	getIntFromConfig("update_check_interval_hours", &intervalHours,
+			 DEFAULT_UPDATE_CHECK_INTERVAL_HOURS);
+	if (intervalHours <= 0) {
+		intervalHours = DEFAULT_UPDATE_CHECK_INTERVAL_HOURS;
+	}
+
+	ReleaseCache cache;
+	if (!loadReleaseCache(cache) || cache.url != url) {
+		cache = ReleaseCache();
+		cache.url = url;
+	}
+
+	const int64_t now = (int64_t)std::time(nullptr);
+	if (now >= cache.checkedAt &&
+	    now - cache.checkedAt < intervalHours * 3600) {
+		// Asked recently, the server isn't asked again, even if it didn't answer
+		if (cache.version.empty()) {
+			obs_log(LOG_INFO,
+				"The last release info request failed %lld min ago, not retrying yet",
+				(long long)((now - cache.checkedAt) / 60));
+			callback({OBS_BGREMOVAL_GITHUB_UTILS_ERROR, "", ""});
 			return;
+		}
+		obs_log(LOG_INFO, "Using the release info cached %lld min ago",
+			(long long)((now - cache.checkedAt) / 60));
+		callback({OBS_BGREMOVAL_GITHUB_UTILS_SUCCESS, cache.body,
+			  cache.version});
+		return;
+	}
+
+	// A failed request counts too, an offline machine doesn't retry on every start
+	cache.checkedAt = now;
+	// Without a cached release there is nothing to revalidate
+	const std::string etag = cache.version.empty() ? "" : cache.etag;
+	const std::string lastModified =
+		cache.version.empty() ? "" : cache.lastModified;
+
+	fetchStringFromUrl(url.c_str(), etag, lastModified, [callback, cache](
+			const FetchResponse &response) mutable {
+		const github_utils_release_information cached = {
+			OBS_BGREMOVAL_GITHUB_UTILS_SUCCESS, cache.body,
+			cache.version};
+		if (response.error != 0 ||
+		    response.statusCode == HTTP_STATUS_NOT_MODIFIED) {
+			saveReleaseCache(cache);
+			if (cache.version.empty()) {
+				callback({OBS_BGREMOVAL_GITHUB_UTILS_ERROR, "",
+					  ""});
+				return;
+			}
+			// Not modified, or the last known release while the server is unreachable
+			callback(cached);
+			return;
+		}
 		// Parse the JSON response
 		obs_data_t *data =
-			obs_data_create_from_json(responseBody.c_str());
+			obs_data_create_from_json(response.body.c_str());
 		if (!data) {
 			obs_log(LOG_INFO,
 				"Failed to parse latest release info");
+			saveReleaseCache(cache);
 			callback({OBS_BGREMOVAL_GITHUB_UTILS_ERROR, "", ""});
 			return;
 		}
@@ -35,10 +162,16 @@ void github_utils_get_release_information(
 		obs_data_release(data);
 
 		// remove the "v" prefix in version, if it exists
-		if (version[0] == 'v') {
+		if (!version.empty() && version[0] == 'v') {
 			version = version.substr(1);
 		}
 
+		cache.version = version;
+		cache.body = body;
+		cache.etag = response.etag;
+		cache.lastModified = response.lastModified;
+		saveReleaseCache(cache);
+
 		callback({OBS_BGREMOVAL_GITHUB_UTILS_SUCCESS, body, version});
 	});
 }
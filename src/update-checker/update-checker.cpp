@@ -7,11 +7,21 @@
 
 #include <plugin-support.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+
 extern "C" const char *PLUGIN_VERSION;
 
-static std::string latestVersionForUpdate;
+// The latest version if it differs from ours. Published once by the check, and
+// never changed after, so readers can keep the string.
+static std::atomic<const std::string *> latestVersionForUpdate{nullptr};
+static std::thread updateCheckThread;
 
-void check_update(void)
+/**
+  * @brief Look up the latest release, off the thread that loads the module
+*/
+static void checkUpdateThread()
 {
 	bool shouldCheckForUpdates = false;
 	if (getFlagFromConfig("check_for_updates", &shouldCheckForUpdates,
@@ -37,22 +47,44 @@ void check_update(void)
 
 		if (info.version == PLUGIN_VERSION) {
 			// No update available, latest version is the same as the current version
-			latestVersionForUpdate.clear();
 			return;
 		}
 
-		latestVersionForUpdate = info.version;
+		const std::string *expected = nullptr;
+		const std::string *version = new std::string(info.version);
+		if (!latestVersionForUpdate.compare_exchange_strong(expected,
+								    version)) {
+			delete version;
+		}
 	};
 
+	// The requests are bounded by the client timeouts
 	github_utils_get_release_information(callback);
 }
 
+void check_update(void)
+{
+	if (updateCheckThread.joinable()) {
+		return;
+	}
+	updateCheckThread = std::thread(checkUpdateThread);
+}
+
+void stop_update_check(void)
+{
+	if (updateCheckThread.joinable()) {
+		updateCheckThread.join();
+	}
+	delete latestVersionForUpdate.exchange(nullptr);
+}
+
 const char *get_latest_version(void)
 {
+	const std::string *latestVersion = latestVersionForUpdate.load();
 	obs_log(LOG_INFO, "get_latest_version: %s",
-		latestVersionForUpdate.c_str());
-	if (latestVersionForUpdate.empty()) {
+		latestVersion ? latestVersion->c_str() : "");
+	if (latestVersion == nullptr) {
 		return nullptr;
 	}
-	return latestVersionForUpdate.c_str();
+	return latestVersion->c_str();
 }
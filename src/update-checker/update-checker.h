@@ -4,7 +4,18 @@
 extern "C" {
 #endif
 
+/**
+  * @brief Start looking up the latest release on a background thread
+*/
 void check_update(void);
+/**
+  * @brief Wait for the lookup to end, on module unload
+*/
+void stop_update_check(void);
+/**
+  * @brief The latest release if it is newer than this one, or NULL if it isn't or
+  * the lookup hasn't finished
+*/
 const char *get_latest_version(void);
 
 #ifdef __cplusplus